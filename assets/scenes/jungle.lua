@@ -0,0 +1,94 @@
+-- Jungle level.
+-- Only run when assets/scenes/jungle.scene is missing or was built from an older
+-- version of this file, so anything random here stays the same between runs.
+-- The world size is read from the map, delete jungle.scene after resizing it.
+
+local MAP_FILE = "./assets/tilemaps/jungle.map"
+local TILE_SIZE = 32
+local MAP_COLUMNS, MAP_ROWS = map_size(MAP_FILE)
+local WORLD_WIDTH = MAP_COLUMNS * TILE_SIZE
+local WORLD_HEIGHT = MAP_ROWS * TILE_SIZE
+
+local images = {
+    "bullet", "chopper-spritesheet", "chopper", "landing-base", "radar", "takeoff-base",
+    "tank-panther-down", "tank-panther-left", "tank-panther-right", "tank-panther-up",
+    "tank-tiger-down", "tank-tiger-left", "tank-tiger-right", "tank-tiger-up",
+    "tree",
+    "truck-ford-down", "truck-ford-killed", "truck-ford-left", "truck-ford-right", "truck-ford-up"
+}
+
+local scene = {
+    textures = {
+        ["jungle-tileset"] = "./assets/tilemaps/jungle.png"
+    },
+    sounds = {
+        helicopter = "./assets/sounds/helicopter.wav"
+    },
+    fonts = {
+        { id = "charriot-font", file = "./assets/fonts/charriot.ttf", size = 20 },
+        { id = "arial-font", file = "./assets/fonts/arial.ttf", size = 12 }
+    },
+    scripts = {
+        drift = "./assets/scripts/drift.lua",
+        patrol = "./assets/scripts/patrol.lua"
+    },
+    -- Background music is streamed from disk, not decoded up front like the sounds:
+    -- music = { file = "./assets/sounds/<track>.ogg", volume = 0.5, fade_ms = 2000 },
+    -- The binary version is made with `make maps`
+    tilemap = {
+        file = MAP_FILE,
+        binary_file = "./assets/tilemaps/jungle.tmap",
+        tileset = "jungle-tileset",
+        tile_size = TILE_SIZE,
+        tileset_columns = 10
+    },
+    -- Chopper sprite sheet: 32x32 frames, 2 rotor frames per row, one row per direction
+    animations = {
+        { name = "chopper-up", frame_width = 32, frame_height = 32, column = 0, row = 0, frames = 2, fps = 15 },
+        { name = "chopper-right", frame_width = 32, frame_height = 32, column = 0, row = 1, frames = 2, fps = 15 },
+        { name = "chopper-down", frame_width = 32, frame_height = 32, column = 0, row = 2, frames = 2, fps = 15 },
+        { name = "chopper-left", frame_width = 32, frame_height = 32, column = 0, row = 3, frames = 2, fps = 15 }
+    },
+    entities = {
+        -- The camera follows the chopper around the world
+        {
+            transform = { position = { WORLD_WIDTH / 2, WORLD_HEIGHT / 2 }, scale = { 1, 1 }, rotation = 0 },
+            rigidbody = { velocity = { 40, 25 } },
+            sprite = { texture = "chopper-spritesheet", width = 32, height = 32 },
+            animation = "chopper-right",
+            camera = {},
+            audio_source = { sound = "helicopter", volume = 0.8, range = 600, priority = 10, loop = true }
+        },
+        -- Rides on the chopper (entity 1), its transform is worked out from the parent's
+        {
+            transform = {},
+            sprite = { texture = "radar", width = 64, height = 64 },
+            parent = { entity = 1, offset = { 8, -12 }, scale = { 0.25, 0.25 } }
+        },
+        {
+            transform = { position = { 10, 10 }, scale = { 1, 1 } },
+            text_label = { text = "2D GAME ENGINE", font = "charriot-font", color = { 255, 255, 255, 255 }, fixed = true }
+        }
+    }
+}
+
+for _, image in ipairs(images) do
+    scene.textures[image] = "./assets/images/" .. image .. ".png"
+end
+
+math.randomseed(2023)
+for i = 1, 20 do
+    table.insert(scene.entities, {
+        transform = {
+            position = { math.random(0, WORLD_WIDTH - 1), math.random(0, WORLD_HEIGHT - 1) },
+            scale = { 1, 1 },
+            rotation = math.random(0, 359)
+        },
+        rigidbody = { velocity = { math.random(-100, 99), math.random(-100, 99) } },
+        sprite = { texture = images[math.random(#images)], width = 50, height = 50 },
+        box_collider = { width = 50, height = 50 },
+        script = i % 2 == 0 and "patrol" or "drift"
+    })
+end
+
+return scene
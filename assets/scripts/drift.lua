@@ -0,0 +1,40 @@
+-- Makes entities drift around instead of flying in straight lines.
+-- update() is called once per frame with every entity that uses this script.
+-- Scripts can also set `budget_ms` (time per call, 2 ms by default) and
+-- `resumable = true` to be suspended and resumed next frame when they run out
+-- of time instead of being aborted.
+
+-- How fast each entity turns, stored by the engine in packed arrays instead of
+-- one Lua table per entity
+define_component("drift", { turn_rate = "float" })
+
+function update(entities, dt)
+    -- Entities seen for the first time get a random turn rate
+    for i = 1, entities:size() do
+        local entity = entities:entity(i)
+        if not entity:has("drift") then
+            entity:add("drift", { turn_rate = math.random(-45, 45) })
+        end
+    end
+
+    local drift = component_view("drift")
+    local turnRates = drift:column("turn_rate")
+    for i = 1, drift:size() do
+        local entity = drift:entity(i)
+        local turnRate = turnRates:get(i)
+        local angle = math.rad(turnRate) * dt
+        local c = math.cos(angle)
+        local s = math.sin(angle)
+
+        local rigidbody = entity:rigidbody()
+        if rigidbody then
+            local velocity = rigidbody.velocity
+            local x = velocity.x
+            velocity.x = x * c - velocity.y * s
+            velocity.y = x * s + velocity.y * c
+        end
+
+        local transform = entity:transform()
+        transform.rotation = transform.rotation + turnRate * dt
+    end
+end
@@ -0,0 +1,21 @@
+-- Turns the entity around every few seconds.
+-- behavior() runs as its own coroutine for every entity using this script and
+-- only wakes up when its wait is over, so patrolling entities cost nothing in
+-- between. Components are looked up again after every wait because pools can
+-- move while the coroutine sleeps.
+
+local PATROL_SECONDS = 3
+
+function behavior(entity)
+    -- Spread the turns out instead of having everyone turn on the same frame
+    wait((entity:id() % 10) / 10)
+
+    while true do
+        wait(PATROL_SECONDS)
+        local rigidbody = entity:rigidbody()
+        if rigidbody then
+            rigidbody.velocity.x = -rigidbody.velocity.x
+            rigidbody.velocity.y = -rigidbody.velocity.y
+        end
+    end
+end
@@ -0,0 +1,75 @@
+#include "./AnimationLibrary.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+
+
+AnimationLibrary::AnimationLibrary() {
+    Logger::Success("AnimationLibrary constructor called!");
+}
+
+AnimationLibrary::~AnimationLibrary() {
+    Logger::Success("AnimationLibrary destructor called!");
+}
+
+/**
+ * Compiles a clip made of `frameCount` frames laid out left to right on one row of a
+ * sprite sheet and returns its id. Adding a clip with an existing name replaces it.
+*/
+int AnimationLibrary::AddClip(
+    const std::string& clipName,
+    int frameWidth,
+    int frameHeight,
+    int firstColumn,
+    int row,
+    int frameCount,
+    int framesPerSecond,
+    bool loop
+) {
+    // The frames of a replaced clip are dropped and the ones after them moved down
+    auto existing = clipIds.find(clipName);
+    if (existing != clipIds.end()) {
+        const AnimationClip old = clips[existing->second];
+        frames.erase(frames.begin() + old.firstFrame, frames.begin() + old.firstFrame + old.frameCount);
+        for (AnimationClip& other: clips) {
+            if (other.firstFrame > old.firstFrame) {
+                other.firstFrame -= old.frameCount;
+            }
+        }
+    }
+
+    AnimationClip clip;
+    clip.firstFrame = static_cast<int>(frames.size());
+    clip.frameCount = std::max(frameCount, 1);
+    clip.frameDurationMs = std::max(1000 / std::max(framesPerSecond, 1), 1);
+    clip.loop = loop;
+
+    for (int i = 0; i < clip.frameCount; i++) {
+        frames.push_back({ (firstColumn + i) * frameWidth, row * frameHeight, frameWidth, frameHeight });
+    }
+
+    if (existing != clipIds.end()) {
+        clips[existing->second] = clip;
+        return existing->second;
+    }
+
+    const int clipId = static_cast<int>(clips.size());
+    clips.push_back(clip);
+    clipIds.insert(std::make_pair(clipName, clipId));
+    return clipId;
+}
+
+/**
+ * Returns -1 if there is no clip with that name
+*/
+int AnimationLibrary::GetClipId(const std::string& clipName) const {
+    auto clip = clipIds.find(clipName);
+    return clip != clipIds.end() ? clip->second : -1;
+}
+
+const std::vector<AnimationClip>& AnimationLibrary::GetClips() const {
+    return clips;
+}
+
+const std::vector<SDL_Rect>& AnimationLibrary::GetFrames() const {
+    return frames;
+}
@@ -0,0 +1,51 @@
+#ifndef ANIMATIONLIBRARY_H
+#define ANIMATIONLIBRARY_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+
+struct AnimationClip {
+    // Index of the first frame of the clip in the frame table
+    int firstFrame;
+    int frameCount;
+    int frameDurationMs;
+    bool loop;
+};
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Animation Library //////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Every clip is compiled once into a run of source rects in one flat frame
+// table. Entities only reference a clip by its id, so a thousand choppers
+// playing the same clip share the same few rects and animating one is an
+// integer division and a table lookup.
+////////////////////////////////////////////////////////////////////////////
+class AnimationLibrary {
+    private:
+        std::vector<SDL_Rect> frames;
+        std::vector<AnimationClip> clips;
+        std::map<std::string, int> clipIds;
+
+    public:
+        AnimationLibrary();
+        ~AnimationLibrary();
+
+        int AddClip(
+            const std::string& clipName,
+            int frameWidth,
+            int frameHeight,
+            int firstColumn,
+            int row,
+            int frameCount,
+            int framesPerSecond,
+            bool loop = true
+        );
+        int GetClipId(const std::string& clipName) const;
+
+        const std::vector<AnimationClip>& GetClips() const;
+        const std::vector<SDL_Rect>& GetFrames() const;
+};
+
+#endif
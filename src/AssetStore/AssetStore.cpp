@@ -13,11 +13,24 @@ AssetStore::~AssetStore() {
     Logger::Success("Registry destructor called!");
 }
 
+/**
+ * Sounds can still be playing until the AudioThread stopped, clear the assets after it
+*/
 void AssetStore::ClearAssests() {
     for (auto texture: textures) {
         SDL_DestroyTexture(texture.second);
     }
     textures.clear();
+
+    for (auto sound: sounds) {
+        Mix_FreeChunk(sound.second);
+    }
+    sounds.clear();
+
+    for (auto font: fonts) {
+        TTF_CloseFont(font.second);
+    }
+    fonts.clear();
 }
 
 void AssetStore::AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& path) {
@@ -32,4 +45,61 @@ void AssetStore::AddTexture(SDL_Renderer* renderer, const std::string& assetId,
 
 SDL_Texture* AssetStore::GetTexture(const std::string& assetId) {
     return textures.at(assetId);
-}
\ No newline at end of file
+}
+
+/**
+ * Decodes a sound into a Mix_Chunk. Sounds are only ever decoded once, every
+ * emitter that plays the same asset shares the chunk. Decoding converts to the
+ * format of the audio device, so the AudioThread has to have opened it first.
+ * Without a device the game runs silent and sounds aren't loaded.
+*/
+void AssetStore::AddSound(const std::string& assetId, const std::string& path) {
+    if (sounds.find(assetId) != sounds.end()) {
+        return;
+    }
+    if (!Mix_QuerySpec(nullptr, nullptr, nullptr)) {
+        Logger::Log("No audio device, sound " + assetId + " not loaded");
+        return;
+    }
+
+    Mix_Chunk* sound = Mix_LoadWAV(path.c_str());
+    if (!sound) {
+        Logger::Err("Could not load sound " + path + ": " + Mix_GetError());
+        return;
+    }
+
+    sounds.insert(std::make_pair(assetId, sound));
+}
+
+/**
+ * Returns nullptr if the sound was never loaded
+*/
+Mix_Chunk* AssetStore::GetSound(const std::string& assetId) {
+    auto sound = sounds.find(assetId);
+    return sound != sounds.end() ? sound->second : nullptr;
+}
+
+/**
+ * Opens a font at a given size. The same file at another size is another asset.
+*/
+void AssetStore::AddFont(const std::string& assetId, const std::string& path, int fontSize) {
+    if (fonts.find(assetId) != fonts.end()) {
+        return;
+    }
+
+    TTF_Font* font = TTF_OpenFont(path.c_str(), fontSize);
+    if (!font) {
+        Logger::Err("Could not load font " + path + ": " + TTF_GetError());
+        return;
+    }
+
+    fonts.insert(std::make_pair(assetId, font));
+}
+
+/**
+ * Returns nullptr if the font was never loaded
+*/
+TTF_Font* AssetStore::GetFont(const std::string& assetId) {
+    auto font = fonts.find(assetId);
+    return font != fonts.end() ? font->second : nullptr;
+}
@@ -4,11 +4,15 @@
 #include <map>
 #include <string>
 #include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_ttf.h>
 
 
 class AssetStore {
     private:
         std::map<std::string, SDL_Texture*> textures;
+        std::map<std::string, Mix_Chunk*> sounds;
+        std::map<std::string, TTF_Font*> fonts;
 
     public:
         AssetStore();
@@ -16,6 +20,10 @@ class AssetStore {
         void ClearAssests();
         void AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& path);
         SDL_Texture* GetTexture(const std::string& assetId);
+        void AddSound(const std::string& assetId, const std::string& path);
+        Mix_Chunk* GetSound(const std::string& assetId);
+        void AddFont(const std::string& assetId, const std::string& path, int fontSize);
+        TTF_Font* GetFont(const std::string& assetId);
 };
 
 #endif
\ No newline at end of file
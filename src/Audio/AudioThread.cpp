@@ -0,0 +1,260 @@
+#include "./AudioThread.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+
+AudioThread::AudioThread() {
+    Logger::Success("AudioThread constructor called!");
+}
+
+AudioThread::~AudioThread() {
+    Stop();
+    Logger::Success("AudioThread destructor called!");
+}
+
+/**
+ * Starts the thread and waits until it managed (or failed) to open the audio device.
+ * Returns false if there is no audio, every request is then silently ignored.
+*/
+bool AudioThread::Start(int channelCount) {
+    if (running) {
+        return true;
+    }
+
+    deviceState = 0;
+    running = true;
+    thread = std::thread(&AudioThread::Run, this, channelCount);
+
+    while (deviceState == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (deviceState < 0) {
+        thread.join();
+        running = false;
+        Logger::Err("Error opening audio device.");
+        return false;
+    }
+
+    Logger::Success("Audio thread started");
+    return true;
+}
+
+/**
+ * Lets the thread drain the queue, stop everything and close the device, then joins it
+*/
+void AudioThread::Stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    thread.join();
+}
+
+bool AudioThread::IsRunning() const {
+    return running;
+}
+
+int AudioThread::GetBytesPerMs() const {
+    return bytesPerMs;
+}
+
+unsigned int AudioThread::GetDroppedCommands() const {
+    return droppedCommands;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Audio side ///////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+void AudioThread::Run(int channelCount) {
+    if (Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, 2, 2048) != 0) {
+        deviceState = -1;
+        return;
+    }
+    Mix_AllocateChannels(channelCount);
+
+    int frequency = 0;
+    Uint16 format = 0;
+    int outputChannels = 0;
+    if (Mix_QuerySpec(&frequency, &format, &outputChannels)) {
+        bytesPerMs = std::max(frequency * outputChannels * ((format & 0xFF) / 8) / 1000, 1);
+    }
+    deviceState = 1;
+
+    AudioCommand command;
+    while (running) {
+        bool idle = true;
+        while (commands.TryPop(command)) {
+            Execute(command);
+            idle = false;
+        }
+
+        // Requests come in at most once per frame, a millisecond of latency is plenty
+        if (idle) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Whatever was requested before Stop still gets done, then shut down
+    while (commands.TryPop(command)) {
+        Execute(command);
+    }
+
+    Mix_HaltChannel(-1);
+    Mix_HaltMusic();
+    for (auto track: music) {
+        Mix_FreeMusic(track.second);
+    }
+    music.clear();
+    Mix_CloseAudio();
+}
+
+/**
+ * Music is opened once per path and streamed, never decoded whole.
+ * (No logging from here, the Logger belongs to the game thread.)
+*/
+Mix_Music* AudioThread::GetMusic(const std::string& path) {
+    auto track = music.find(path);
+    if (track != music.end()) {
+        return track->second;
+    }
+
+    Mix_Music* loaded = Mix_LoadMUS(path.c_str());
+    if (loaded) {
+        music.insert(std::make_pair(path, loaded));
+    }
+    return loaded;
+}
+
+void AudioThread::Execute(const AudioCommand& command) {
+    switch (command.type) {
+        case AudioCommandType::PLAY_CHANNEL: {
+            Mix_PlayChannel(command.channel, command.chunk, command.loops);
+            break;
+        }
+        case AudioCommandType::HALT_CHANNEL: {
+            Mix_HaltChannel(command.channel);
+            break;
+        }
+        case AudioCommandType::HALT_ALL: {
+            Mix_HaltChannel(-1);
+            break;
+        }
+        case AudioCommandType::SET_VOLUME: {
+            Mix_Volume(command.channel, command.volume);
+            break;
+        }
+        case AudioCommandType::SET_PANNING: {
+            Mix_SetPanning(command.channel, command.left, command.right);
+            break;
+        }
+        case AudioCommandType::PLAY_MUSIC: {
+            Mix_Music* track = GetMusic(command.path);
+            if (track) {
+                Mix_FadeInMusic(track, command.loops, command.fadeMs);
+            }
+            break;
+        }
+        case AudioCommandType::STOP_MUSIC: {
+            Mix_FadeOutMusic(command.fadeMs);
+            break;
+        }
+        case AudioCommandType::SET_MUSIC_VOLUME: {
+            Mix_VolumeMusic(command.volume);
+            break;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Game side ////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Never blocks: if the audio thread fell that far behind, the request is dropped and counted
+*/
+bool AudioThread::Push(const AudioCommand& command) {
+    if (!running) {
+        return false;
+    }
+    if (!commands.TryPush(command)) {
+        droppedCommands++;
+        return false;
+    }
+    return true;
+}
+
+void AudioThread::PlayChannel(int channel, Mix_Chunk* chunk, int loops) {
+    AudioCommand command = {};
+    command.type = AudioCommandType::PLAY_CHANNEL;
+    command.channel = channel;
+    command.chunk = chunk;
+    command.loops = loops;
+    Push(command);
+}
+
+void AudioThread::HaltChannel(int channel) {
+    AudioCommand command = {};
+    command.type = AudioCommandType::HALT_CHANNEL;
+    command.channel = channel;
+    Push(command);
+}
+
+void AudioThread::HaltAll() {
+    AudioCommand command = {};
+    command.type = AudioCommandType::HALT_ALL;
+    Push(command);
+}
+
+void AudioThread::SetVolume(int channel, int volume) {
+    AudioCommand command = {};
+    command.type = AudioCommandType::SET_VOLUME;
+    command.channel = channel;
+    command.volume = volume;
+    Push(command);
+}
+
+void AudioThread::SetPanning(int channel, Uint8 left, Uint8 right) {
+    AudioCommand command = {};
+    command.type = AudioCommandType::SET_PANNING;
+    command.channel = channel;
+    command.left = left;
+    command.right = right;
+    Push(command);
+}
+
+void AudioThread::PlayMusic(const std::string& path, int loops, int fadeMs) {
+    if (path.size() >= sizeof(AudioCommand::path)) {
+        Logger::Err("Music path too long: " + path);
+        return;
+    }
+    if (!std::ifstream(path).good()) {
+        Logger::Err("Could not open music " + path);
+        return;
+    }
+
+    AudioCommand command = {};
+    command.type = AudioCommandType::PLAY_MUSIC;
+    command.loops = loops;
+    command.fadeMs = fadeMs;
+    std::strncpy(command.path, path.c_str(), sizeof(command.path) - 1);
+    Push(command);
+}
+
+void AudioThread::StopMusic(int fadeMs) {
+    AudioCommand command = {};
+    command.type = AudioCommandType::STOP_MUSIC;
+    command.fadeMs = fadeMs;
+    Push(command);
+}
+
+void AudioThread::SetMusicVolume(int volume) {
+    AudioCommand command = {};
+    command.type = AudioCommandType::SET_MUSIC_VOLUME;
+    command.volume = volume;
+    Push(command);
+}
@@ -0,0 +1,91 @@
+#ifndef AUDIOTHREAD_H
+#define AUDIOTHREAD_H
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <SDL2/SDL_mixer.h>
+#include "./SPSCQueue.h"
+
+enum class AudioCommandType {
+    PLAY_CHANNEL,
+    HALT_CHANNEL,
+    HALT_ALL,
+    SET_VOLUME,
+    SET_PANNING,
+    PLAY_MUSIC,
+    STOP_MUSIC,
+    SET_MUSIC_VOLUME
+};
+
+// Commands are copied into the queue, so they only hold plain data
+struct AudioCommand {
+    AudioCommandType type;
+    int channel;
+    Mix_Chunk* chunk;
+    int loops;
+    int volume;
+    int fadeMs;
+    Uint8 left;
+    Uint8 right;
+    char path[128];
+};
+
+const size_t AUDIO_COMMAND_QUEUE_SIZE = 4096;
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Audio Thread ///////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Owns the audio device and playback. It opens the device, executes every
+// playback request and closes the device, all on its own thread. The game
+// thread only pushes commands into a lock free queue, so a frame never waits
+// on SDL's audio lock. Music is streamed from disk with Mix_LoadMUS instead
+// of being decoded up front like the sound effect chunks.
+// Those chunks are the exception: the AssetStore decodes them on the game
+// thread, which doesn't touch the channels, once Start() returned with the
+// device open, and frees them after Stop().
+////////////////////////////////////////////////////////////////////////////
+class AudioThread {
+    private:
+        std::thread thread;
+        std::atomic<bool> running{false};
+        // 0 = still opening the device, 1 = open, -1 = failed
+        std::atomic<int> deviceState{0};
+        std::atomic<int> bytesPerMs{0};
+        std::atomic<unsigned int> droppedCommands{0};
+
+        SPSCQueue<AudioCommand, AUDIO_COMMAND_QUEUE_SIZE> commands;
+
+        // Only touched by the audio thread
+        std::map<std::string, Mix_Music*> music;
+
+        void Run(int channelCount);
+        void Execute(const AudioCommand& command);
+        Mix_Music* GetMusic(const std::string& path);
+        bool Push(const AudioCommand& command);
+
+    public:
+        AudioThread();
+        ~AudioThread();
+
+        bool Start(int channelCount);
+        void Stop();
+        bool IsRunning() const;
+
+        // Mixer bytes per millisecond of audio, 0 if there is no audio device
+        int GetBytesPerMs() const;
+        unsigned int GetDroppedCommands() const;
+
+        //////// Requests, only from the game thread ////////
+        void PlayChannel(int channel, Mix_Chunk* chunk, int loops);
+        void HaltChannel(int channel);
+        void HaltAll();
+        void SetVolume(int channel, int volume);
+        void SetPanning(int channel, Uint8 left, Uint8 right);
+        void PlayMusic(const std::string& path, int loops = -1, int fadeMs = 0);
+        void StopMusic(int fadeMs = 0);
+        void SetMusicVolume(int volume);
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// SPSC Queue /////////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Fixed capacity ring buffer for exactly one producer thread and exactly one
+// consumer thread. Neither side ever locks or waits: pushing into a full
+// queue or popping from an empty one just returns false.
+//
+// head and tail only ever grow (the slot is index & mask), the producer only
+// writes tail and the consumer only writes head, and they sit on different
+// cache lines so the two threads don't keep stealing the line from each other.
+////////////////////////////////////////////////////////////////////////////
+template <typename T, size_t Capacity>
+class SPSCQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+    private:
+        static const size_t mask = Capacity - 1;
+
+        // Next slot to read, written by the consumer
+        alignas(64) std::atomic<size_t> head{0};
+        // Next slot to write, written by the producer
+        alignas(64) std::atomic<size_t> tail{0};
+
+        alignas(64) std::vector<T> slots;
+
+    public:
+        SPSCQueue(): slots(Capacity) {}
+
+        /**
+         * Producer side. Returns false if the queue is full.
+        */
+        bool TryPush(const T& item) {
+            const size_t currentTail = tail.load(std::memory_order_relaxed);
+            if (currentTail - head.load(std::memory_order_acquire) == Capacity) {
+                return false;
+            }
+            slots[currentTail & mask] = item;
+            tail.store(currentTail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Consumer side. Returns false if the queue is empty.
+        */
+        bool TryPop(T& item) {
+            const size_t currentHead = head.load(std::memory_order_relaxed);
+            if (currentHead == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            item = slots[currentHead & mask];
+            head.store(currentHead + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool IsEmpty() const {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+};
+
+#endif
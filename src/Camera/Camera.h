@@ -0,0 +1,59 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <cmath>
+#include <glm/glm.hpp>
+#include <SDL2/SDL.h>
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Camera /////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// The part of the world that ends up in the window. Everything in the game
+// lives in world coordinates and only gets converted to screen pixels at
+// draw time, so the world can be any size and be looked at from any zoom.
+////////////////////////////////////////////////////////////////////////////
+struct Camera {
+    // World coordinates of the top left corner of the view
+    glm::vec2 position = glm::vec2(0, 0);
+    // Screen pixels per world unit
+    float zoom = 1.0f;
+    // Size of the window area the camera draws into
+    int viewportWidth = 0;
+    int viewportHeight = 0;
+
+    glm::vec2 GetViewSize() const {
+        return glm::vec2(viewportWidth, viewportHeight) / zoom;
+    }
+
+    /**
+     * World rect that is visible, rounded outwards so it covers every partially visible pixel
+    */
+    SDL_Rect GetVisibleRect() const {
+        const glm::vec2 end = position + GetViewSize();
+        const int x = static_cast<int>(std::floor(position.x));
+        const int y = static_cast<int>(std::floor(position.y));
+        return { x, y, static_cast<int>(std::ceil(end.x)) - x, static_cast<int>(std::ceil(end.y)) - y };
+    }
+
+    glm::vec2 WorldToScreen(const glm::vec2& world) const {
+        return (world - position) * zoom;
+    }
+
+    glm::vec2 ScreenToWorld(const glm::vec2& screen) const {
+        return screen / zoom + position;
+    }
+
+    /**
+     * Screen rect of a world rect, used for everything that is drawn
+    */
+    SDL_Rect WorldToScreen(const SDL_Rect& world) const {
+        const glm::vec2 start = WorldToScreen(glm::vec2(world.x, world.y));
+        const glm::vec2 end = WorldToScreen(glm::vec2(world.x + world.w, world.y + world.h));
+        const int x = static_cast<int>(std::floor(start.x));
+        const int y = static_cast<int>(std::floor(start.y));
+        // Round both edges so neighbouring rects (tile chunks) never leave a gap between them
+        return { x, y, static_cast<int>(std::floor(end.x)) - x, static_cast<int>(std::floor(end.y)) - y };
+    }
+};
+
+#endif
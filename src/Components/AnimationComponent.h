@@ -0,0 +1,28 @@
+#ifndef ANIMATIONCOMPONENT_H
+#define ANIMATIONCOMPONENT_H
+
+#include "../ECS/ECS.h"
+
+/**
+ * Plays a clip from the AnimationLibrary on the entity's sprite.
+ * Everything about the clip lives in the library, the entity only keeps where it is in it.
+*/
+struct AnimationComponent {
+    // Set it to switch clips, the new one starts from its first frame
+    int clipId;
+    // Clip the frame and start time below belong to
+    int playingClipId;
+    // Current frame, relative to the start of the clip
+    int frameIndex;
+    // Animation clock time at which the clip started, -1 to start on the next update
+    int startTimeMs;
+
+    AnimationComponent(int clipId = -1) {
+        this->clipId = clipId;
+        this->playingClipId = -1;
+        this->frameIndex = -1;
+        this->startTimeMs = -1;
+    }
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef AUDIOSOURCECOMPONENT_H
+#define AUDIOSOURCECOMPONENT_H
+
+#include <string>
+#include "../ECS/ECS.h"
+
+/**
+ * A sound that plays from the entity's position. It fades out with the distance to the
+ * listener and is silent beyond `range` world units. When there are more audible sources
+ * than mixer channels, the ones with the lowest priority (then the quietest) are virtual:
+ * they keep their state but don't use a channel until they win one back.
+ * That state belongs to the AudioSystem, not here: audio is presentation, so it isn't part
+ * of the simulation that is checksummed, rolled back and replayed.
+*/
+struct AudioSourceComponent {
+    std::string soundId;
+    float volume;
+    float range;
+    int priority;
+    bool loop;
+
+    AudioSourceComponent(
+        std::string soundId = "",
+        float volume = 1.0f,
+        float range = 500.0f,
+        int priority = 0,
+        bool loop = false
+    ) {
+        this->soundId = soundId;
+        this->volume = volume;
+        this->range = range;
+        this->priority = priority;
+        this->loop = loop;
+    }
+};
+
+// Snapshot fallback
+inline void SaveComponent(SnapshotWriter& writer, const AudioSourceComponent& source) {
+    writer.WriteString(source.soundId);
+    writer.Write(source.volume);
+    writer.Write(source.range);
+    writer.Write(source.priority);
+    writer.Write(source.loop);
+}
+
+inline bool LoadComponent(SnapshotReader& reader, AudioSourceComponent& source) {
+    return reader.ReadString(source.soundId)
+        && reader.Read(source.volume)
+        && reader.Read(source.range)
+        && reader.Read(source.priority)
+        && reader.Read(source.loop);
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef BOXCOLLIDERCOMPONENT_H
+#define BOXCOLLIDERCOMPONENT_H
+
+#include <glm/glm.hpp>
+#include "../ECS/ECS.h"
+using vec2 = glm::vec2;
+
+struct BoxColliderComponent {
+    int width;
+    int height;
+    // Offset of the box from the entity's position, before scaling
+    vec2 offset;
+
+    BoxColliderComponent(int width = 0, int height = 0, vec2 offset = vec2(0, 0)) {
+        this->width = width;
+        this->height = height;
+        this->offset = offset;
+    }
+};
+
+#endif
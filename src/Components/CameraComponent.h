@@ -0,0 +1,21 @@
+#ifndef CAMERACOMPONENT_H
+#define CAMERACOMPONENT_H
+
+#include "../ECS/ECS.h"
+
+/**
+ * Makes the camera follow the entity, keeping it in the middle of the view
+*/
+struct CameraComponent {
+    float zoom;
+    float minZoom;
+    float maxZoom;
+
+    CameraComponent(float zoom = 1.0f, float minZoom = 0.25f, float maxZoom = 4.0f) {
+        this->zoom = zoom;
+        this->minZoom = minZoom;
+        this->maxZoom = maxZoom;
+    }
+};
+
+#endif
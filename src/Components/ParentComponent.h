@@ -0,0 +1,32 @@
+#ifndef PARENTCOMPONENT_H
+#define PARENTCOMPONENT_H
+
+#include <glm/glm.hpp>
+#include "../ECS/ECS.h"
+using vec2 = glm::vec2;
+
+/**
+ * Attaches the entity to another one (a turret to its tank, a rotor to its chopper).
+ * The entity's TransformComponent is then derived by the HierarchySystem from the
+ * parent's and the local transform below, write this one to move it.
+*/
+struct ParentComponent {
+    int parentId;
+    // Relative to the parent: the position is from its top-left, scaled and rotated with it
+    vec2 localPosition;
+    vec2 localScale;
+    // A float and not a double like TransformComponent's, a double would leave padding after localScale
+    float localRotation;
+
+    ParentComponent(int parentId = -1, vec2 localPosition = vec2(0, 0), vec2 localScale = vec2(1, 1), float localRotation = 0.0f) {
+        this->parentId = parentId;
+        this->localPosition = localPosition;
+        this->localScale = localScale;
+        this->localRotation = localRotation;
+    }
+};
+
+// The pool hashes it and snapshots save it as raw bytes, uninitialized padding would make both differ from run to run
+static_assert(sizeof(ParentComponent) == sizeof(int) + 2 * sizeof(vec2) + sizeof(float), "ParentComponent must not have padding");
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef SCRIPTCOMPONENT_H
+#define SCRIPTCOMPONENT_H
+
+#include <string>
+#include "../ECS/ECS.h"
+
+/**
+ * Runs a script loaded in the ScriptEngine on the entity. Every entity with the same
+ * script is handed to it in the same call.
+*/
+struct ScriptComponent {
+    std::string scriptId;
+
+    // Index of the script in the engine, owned by the ScriptSystem. -1 until it is looked up
+    int scriptIndex;
+
+    ScriptComponent(std::string scriptId = "") {
+        this->scriptId = scriptId;
+        this->scriptIndex = -1;
+    }
+};
+
+// Snapshot fallback. Only the script name is saved, the index belongs to the engine
+// that loaded the scripts. A loaded component is looked up again by the ScriptSystem,
+// which also starts its behavior over (coroutines can't be saved).
+inline void SaveComponent(SnapshotWriter& writer, const ScriptComponent& script) {
+    writer.WriteString(script.scriptId);
+}
+
+inline bool LoadComponent(SnapshotReader& reader, ScriptComponent& script) {
+    script.scriptIndex = -1;
+    return reader.ReadString(script.scriptId);
+}
+
+#endif
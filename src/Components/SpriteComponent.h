@@ -29,4 +29,19 @@ struct SpriteComponent {
     }
 };
 
+// Snapshot fallback, the asset id is a string (see Snapshot.h)
+inline void SaveComponent(SnapshotWriter& writer, const SpriteComponent& sprite) {
+    writer.WriteString(sprite.assetId);
+    writer.Write(sprite.width);
+    writer.Write(sprite.height);
+    writer.Write(sprite.srcRect);
+}
+
+inline bool LoadComponent(SnapshotReader& reader, SpriteComponent& sprite) {
+    return reader.ReadString(sprite.assetId)
+        && reader.Read(sprite.width)
+        && reader.Read(sprite.height)
+        && reader.Read(sprite.srcRect);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef TEXTLABELCOMPONENT_H
+#define TEXTLABELCOMPONENT_H
+
+#include <string>
+#include <SDL2/SDL.h>
+#include "../ECS/ECS.h"
+
+/**
+ * Text drawn at the entity's position. Fixed labels are in screen pixels (HUD),
+ * the others are in the world and move with the camera.
+*/
+struct TextLabelComponent {
+    std::string text;
+    std::string fontId;
+    SDL_Color color;
+    bool isFixed;
+
+    TextLabelComponent(
+        std::string text = "",
+        std::string fontId = "",
+        SDL_Color color = {255, 255, 255, 255},
+        bool isFixed = true
+    ) {
+        this->text = text;
+        this->fontId = fontId;
+        this->color = color;
+        this->isFixed = isFixed;
+    }
+};
+
+// Snapshot fallback, the text and font id are strings
+inline void SaveComponent(SnapshotWriter& writer, const TextLabelComponent& label) {
+    writer.WriteString(label.text);
+    writer.WriteString(label.fontId);
+    writer.Write(label.color);
+    writer.Write(label.isFixed);
+}
+
+inline bool LoadComponent(SnapshotReader& reader, TextLabelComponent& label) {
+    return reader.ReadString(label.text)
+        && reader.ReadString(label.fontId)
+        && reader.Read(label.color)
+        && reader.Read(label.isFixed);
+}
+
+#endif
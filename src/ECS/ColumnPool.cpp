@@ -0,0 +1,260 @@
+#include "ColumnPool.h"
+#include <cstring>
+#include <algorithm>
+
+static size_t GetElementSize(ColumnType type) {
+    switch (type) {
+        case COLUMN_FLOAT: return sizeof(float);
+        case COLUMN_INT: return sizeof(int32_t);
+        case COLUMN_BOOL: return sizeof(uint8_t);
+    }
+    return 0;
+}
+
+ColumnPool::ColumnPool(const std::vector<ColumnField>& fields): fields(fields) {
+    for (const ColumnField& field: fields) {
+        elementSizes.push_back(GetElementSize(field.type));
+    }
+    columns.resize(fields.size());
+    columnHistories.resize(fields.size());
+}
+
+const std::vector<ColumnField>& ColumnPool::GetFields() const {
+    return fields;
+}
+
+/**
+ * Returns -1 if there is no field with that name
+*/
+int ColumnPool::GetFieldIndex(const std::string& fieldName) const {
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (fields[i].name == fieldName) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int ColumnPool::GetSize() const {
+    return static_cast<int>(entityIds.size());
+}
+
+/**
+ * Returns -1 if the entity doesn't have the component
+*/
+int ColumnPool::GetIndex(int entityId) const {
+    return entityId >= 0 && entityId < static_cast<int>(denseIndices.size()) ? denseIndices[entityId] : -1;
+}
+
+int ColumnPool::GetEntityId(int index) const {
+    return entityIds[index];
+}
+
+/**
+ * Gives the entity a zeroed instance and returns its index. Entities that already have
+ * one keep it.
+*/
+int ColumnPool::Add(int entityId) {
+    const int existing = GetIndex(entityId);
+    if (existing >= 0) {
+        return existing;
+    }
+
+    if (entityId >= static_cast<int>(denseIndices.size())) {
+        denseIndices.resize(entityId + 1, -1);
+    }
+    const int index = GetSize();
+    stateDirty = true;
+    denseIndicesHistory.Touch(denseIndices, entityId);
+    denseIndices[entityId] = index;
+    entityIds.push_back(entityId);
+
+    for (size_t field = 0; field < columns.size(); field++) {
+        columns[field].resize(columns[field].size() + elementSizes[field], 0);
+    }
+    return index;
+}
+
+void ColumnPool::Remove(int entityId) {
+    const int index = GetIndex(entityId);
+    if (index < 0) {
+        return;
+    }
+
+    const int last = GetSize() - 1;
+    stateDirty = true;
+    // The last instance is saved too, it is cut off and could be added back in the same frame
+    TouchInstance(index);
+    TouchInstance(last);
+    for (size_t field = 0; field < columns.size(); field++) {
+        const size_t size = elementSizes[field];
+        if (index != last) {
+            std::memcpy(&columns[field][index * size], &columns[field][last * size], size);
+        }
+        columns[field].resize(last * size);
+    }
+
+    const int movedEntityId = entityIds[last];
+    denseIndicesHistory.Touch(denseIndices, movedEntityId);
+    denseIndicesHistory.Touch(denseIndices, entityId);
+    entityIds[index] = movedEntityId;
+    denseIndices[movedEntityId] = index;
+    entityIds.pop_back();
+    denseIndices[entityId] = -1;
+}
+
+double ColumnPool::GetValue(int field, int index) const {
+    const uint8_t* value = &columns[field][index * elementSizes[field]];
+    switch (fields[field].type) {
+        case COLUMN_FLOAT: {
+            float result;
+            std::memcpy(&result, value, sizeof(result));
+            return result;
+        }
+        case COLUMN_INT: {
+            int32_t result;
+            std::memcpy(&result, value, sizeof(result));
+            return result;
+        }
+        case COLUMN_BOOL:
+            return *value != 0 ? 1.0 : 0.0;
+    }
+    return 0;
+}
+
+void ColumnPool::SetValue(int field, int index, double value) {
+    columnHistories[field].TouchRange(columns[field], index * elementSizes[field], elementSizes[field]);
+    stateDirty = true;
+    uint8_t* destination = &columns[field][index * elementSizes[field]];
+    switch (fields[field].type) {
+        case COLUMN_FLOAT: {
+            const float stored = static_cast<float>(value);
+            std::memcpy(destination, &stored, sizeof(stored));
+            break;
+        }
+        case COLUMN_INT: {
+            const int32_t stored = static_cast<int32_t>(value);
+            std::memcpy(destination, &stored, sizeof(stored));
+            break;
+        }
+        case COLUMN_BOOL:
+            *destination = value != 0 ? 1 : 0;
+            break;
+    }
+}
+
+uint64_t ColumnPool::GetTypeHash() const {
+    uint64_t hash = HashSnapshotType("ColumnPool");
+    for (const ColumnField& field: fields) {
+        hash = HashSnapshotType(field.name.c_str(), hash ^ static_cast<uint64_t>(field.type));
+    }
+    return hash;
+}
+
+/**
+ * [uint32 instance count][entity ids][one block per column]. The sparse indices
+ * are rebuilt from the entity ids when loading.
+*/
+void ColumnPool::Save(SnapshotWriter& writer) const {
+    writer.Write(static_cast<uint32_t>(entityIds.size()));
+    writer.WriteBytes(entityIds.data(), entityIds.size() * sizeof(int));
+    for (const std::vector<uint8_t>& column: columns) {
+        writer.WriteBytes(column.data(), column.size());
+    }
+}
+
+bool ColumnPool::Load(SnapshotReader& reader) {
+    uint32_t count;
+    if (!reader.Read(count) || static_cast<uint64_t>(count) * sizeof(int) > reader.GetRemaining()) {
+        return false;
+    }
+    loadedEntityIds.resize(count);
+    if (!reader.ReadBytes(loadedEntityIds.data(), count * sizeof(int))) {
+        return false;
+    }
+    for (int entityId: loadedEntityIds) {
+        if (entityId < 0) {
+            return false;
+        }
+    }
+
+    loadedColumns.resize(columns.size());
+    for (size_t field = 0; field < columns.size(); field++) {
+        const size_t size = count * elementSizes[field];
+        if (size > reader.GetRemaining()) {
+            return false;
+        }
+        loadedColumns[field].resize(size);
+        reader.ReadBytes(loadedColumns[field].data(), size);
+    }
+    return true;
+}
+
+void ColumnPool::CommitLoad() {
+    ClearHistory();
+    stateDirty = true;
+    entityIds.swap(loadedEntityIds);
+    columns.swap(loadedColumns);
+    std::vector<int>().swap(loadedEntityIds);
+    std::vector<std::vector<uint8_t>>().swap(loadedColumns);
+
+    int maxEntityId = -1;
+    for (int entityId: entityIds) {
+        maxEntityId = std::max(maxEntityId, entityId);
+    }
+    denseIndices.assign(maxEntityId + 1, -1);
+    for (size_t index = 0; index < entityIds.size(); index++) {
+        denseIndices[entityIds[index]] = static_cast<int>(index);
+    }
+}
+
+void ColumnPool::TouchInstance(int index) {
+    entityIdsHistory.Touch(entityIds, index);
+    for (size_t field = 0; field < columns.size(); field++) {
+        columnHistories[field].TouchRange(columns[field], index * elementSizes[field], elementSizes[field]);
+    }
+}
+
+void ColumnPool::BeginFrame(int frame) {
+    for (size_t field = 0; field < columns.size(); field++) {
+        columnHistories[field].BeginFrame(frame, columns[field].size());
+    }
+    entityIdsHistory.BeginFrame(frame, entityIds.size());
+    denseIndicesHistory.BeginFrame(frame, denseIndices.size());
+}
+
+void ColumnPool::Rollback(int frame) {
+    auto onRestore = [this](size_t, size_t) {
+        stateDirty = true;
+    };
+    for (size_t field = 0; field < columns.size(); field++) {
+        columnHistories[field].Rollback(frame, columns[field], onRestore);
+    }
+    entityIdsHistory.Rollback(frame, entityIds, onRestore);
+    denseIndicesHistory.Rollback(frame, denseIndices, onRestore);
+    // A pool that only grew has nothing to copy back but is shorter now
+    stateDirty = true;
+}
+
+void ColumnPool::ClearHistory() {
+    for (RollbackHistory<uint8_t>& history: columnHistories) {
+        history.Clear();
+    }
+    entityIdsHistory.Clear();
+    denseIndicesHistory.Clear();
+}
+
+/**
+ * Instances in dense order and their values. The dense order is part of the state, two
+ * runs that added the same components in another order hash differently.
+*/
+uint64_t ColumnPool::GetStateHash() {
+    if (stateDirty) {
+        stateHash = HashStateBytes(entityIds.data(), entityIds.size() * sizeof(int));
+        for (const std::vector<uint8_t>& column: columns) {
+            stateHash = HashStateBytes(column.data(), column.size(), stateHash);
+        }
+        stateDirty = false;
+    }
+    return stateHash;
+}
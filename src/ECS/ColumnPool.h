@@ -0,0 +1,99 @@
+#ifndef COLUMNPOOL_H
+#define COLUMNPOOL_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Pool.h"
+
+enum ColumnType {
+    COLUMN_FLOAT,
+    COLUMN_INT,
+    COLUMN_BOOL
+};
+
+struct ColumnField {
+    std::string name;
+    ColumnType type;
+
+    bool operator ==(const ColumnField& other) const { return name == other.name && type == other.type; }
+};
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Column Pool ////////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Storage for components whose layout is only known at runtime (defined by
+// scripts). Every field is its own packed array (float, int32 or uint8 for
+// bools) and the entities that have the component are kept densely at the
+// front, so walking one field of every instance reads contiguous memory.
+// Removing swaps the last instance into the hole.
+////////////////////////////////////////////////////////////////////////////
+class ColumnPool : public IPool {
+    private:
+        std::vector<ColumnField> fields;
+        std::vector<size_t> elementSizes;
+        std::vector<std::vector<uint8_t>> columns;
+
+        // Dense index -> entity id, and entity id -> dense index (-1 when it doesn't have one)
+        std::vector<int> entityIds;
+        std::vector<int> denseIndices;
+
+        // Rollback, one history per array
+        std::vector<RollbackHistory<uint8_t>> columnHistories;
+        RollbackHistory<int> entityIdsHistory;
+        RollbackHistory<int> denseIndicesHistory;
+
+        // Script components are small, any write has the whole pool rehashed
+        bool stateDirty = true;
+        uint64_t stateHash = 0;
+
+        // Parsed by Load(), waiting for CommitLoad()
+        std::vector<int> loadedEntityIds;
+        std::vector<std::vector<uint8_t>> loadedColumns;
+
+        void TouchInstance(int index);
+
+    public:
+        ColumnPool(const std::vector<ColumnField>& fields);
+        virtual ~ColumnPool() = default;
+
+        const std::vector<ColumnField>& GetFields() const;
+        int GetFieldIndex(const std::string& fieldName) const;
+
+        // Number of entities that have the component
+        int GetSize() const;
+        int GetIndex(int entityId) const;
+        int GetEntityId(int index) const;
+
+        int Add(int entityId);
+        void Remove(int entityId);
+
+        // Values of one field for every instance, in dense order. The whole column is
+        // saved for rollback, prefer SetValue to write a few of them
+        template <typename T> T* GetColumn(int field) {
+            columnHistories[field].TouchRange(columns[field], 0, columns[field].size());
+            stateDirty = true;
+            return reinterpret_cast<T*>(columns[field].data());
+        }
+
+        template <typename T> const T* ReadColumn(int field) const {
+            return reinterpret_cast<const T*>(columns[field].data());
+        }
+
+        double GetValue(int field, int index) const;
+        void SetValue(int field, int index, double value);
+
+        // Hash of the field names and types
+        uint64_t GetTypeHash() const override;
+        void Save(SnapshotWriter& writer) const override;
+        bool Load(SnapshotReader& reader) override;
+        void CommitLoad() override;
+
+        void BeginFrame(int frame) override;
+        void Rollback(int frame) override;
+        void ClearHistory() override;
+
+        uint64_t GetStateHash() override;
+};
+
+#endif
@@ -1,7 +1,11 @@
 #include "ECS.h"
 #include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
 
 #include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
 
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -16,6 +20,25 @@ int Entity::GetId() const {
 //////////////////////////////////////////////////////////////////////////////////
 int IComponent::nextId = 0;
 
+int IComponent::ReserveId() {
+    if (nextId >= static_cast<int>(MAX_COMPONENTS)) {
+        return -1;
+    }
+    return nextId++;
+}
+
+int IComponent::ReserveTypeId(const char* typeName) {
+    const int id = ReserveId();
+    if (id < 0) {
+        Logger::Err(
+            std::string("No component id left for ") + typeName + ", all " + std::to_string(MAX_COMPONENTS) +
+            " are taken by the components used so far and the ones scripts defined"
+        );
+        std::abort();
+    }
+    return id;
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////// System ///////////////////////////////////////
@@ -36,6 +59,10 @@ void System::RemoveEntityFromSystem(Entity entity) {
     }));
 }
 
+void System::ClearSystemEntities() {
+    entities.clear();
+}
+
 const std::vector<Entity>& System::GetSystemEntities() const {
     return entities;
 }
@@ -46,6 +73,12 @@ const Signature& System::GetComponentSignature() const {
     return componentSignature;
 }
 
+void System::RequireComponent(int componentId) {
+    if (componentId >= 0 && componentId < static_cast<int>(MAX_COMPONENTS)) {
+        componentSignature.set(componentId);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////
 /////////////////////////////// Registry ///////////////////////////////
 ////////////////////////////////////////////////////////////////////////
@@ -62,14 +95,16 @@ Registry::~Registry() {
  * Creates a Entity and adds it to the queue of entities to be spawned
 */
 Entity Registry::SpawnEntity() {
-    u_int8_t entityId;
+    int entityId;
     entityId = entityCount++;
 
+    SaveStructureForRollback();
+
     Entity newEntity(entityId);
     newEntity.registry = this;
     entitiesToBeSpawned.insert(newEntity);
 
-    if (entityId >= entityComponentSignatures.size()) {
+    if (entityId >= static_cast<int>(entityComponentSignatures.size())) {
         entityComponentSignatures.resize(entityId + 1);
     }
 
@@ -79,14 +114,124 @@ Entity Registry::SpawnEntity() {
 }
 
 
+/**
+ * Creates `count` entities with consecutive ids in one go, returned in `spawned`
+*/
+void Registry::SpawnEntities(int count, std::vector<Entity>& spawned) {
+    spawned.clear();
+    if (count <= 0) {
+        return;
+    }
+    spawned.reserve(count);
+    SaveStructureForRollback();
+
+    const int firstId = entityCount;
+    entityCount += count;
+    if (entityCount > static_cast<int>(entityComponentSignatures.size())) {
+        entityComponentSignatures.resize(entityCount);
+    }
+
+    for (int entityId = firstId; entityId < entityCount; entityId++) {
+        Entity newEntity(entityId);
+        newEntity.registry = this;
+        // Ids only go up, so every insert lands at the end of the set
+        entitiesToBeSpawned.insert(entitiesToBeSpawned.end(), newEntity);
+        spawned.push_back(newEntity);
+    }
+
+    Logger::Success(std::to_string(count) + " entities created with IDs " + std::to_string(firstId) + " to " + std::to_string(entityCount - 1));
+}
+
+
 /**
  * DESTROYS a Entity and adds it to the queue of entities to be killed
 */
 void Registry::KillEntity(Entity entity) {
+    SaveStructureForRollback();
     entitiesToBeKilled.insert(entity);
     entityCount--;
 }
 
+//////// Runtime components ////////
+
+/**
+ * Defines a component type with the given fields and returns its id. It gets a Signature
+ * bit like any other component. Registering an existing name with the same fields returns
+ * the existing id, the layout of a registered component can't change.
+*/
+int Registry::RegisterColumnComponent(const std::string& name, const std::vector<ColumnField>& fields) {
+    auto existing = columnComponentIds.find(name);
+    if (existing != columnComponentIds.end()) {
+        if (GetColumnPool(existing->second)->GetFields() != fields) {
+            Logger::Err("Component " + name + " is already registered with different fields");
+            return -1;
+        }
+        return existing->second;
+    }
+
+    const int componentId = IComponent::ReserveId();
+    if (componentId < 0) {
+        Logger::Err("Can't register component " + name + ", all " + std::to_string(MAX_COMPONENTS) + " component ids are taken");
+        return -1;
+    }
+
+    if (componentId >= static_cast<int>(componentPools.size())) {
+        componentPools.resize(componentId + 1, nullptr);
+    }
+    componentPools[componentId] = std::make_shared<ColumnPool>(fields);
+    SetUpPool(componentId);
+    columnComponents.set(componentId);
+    columnComponentIds.insert(std::make_pair(name, componentId));
+
+    Logger::Success("Component " + name + " registered with ID = " + std::to_string(componentId));
+    return componentId;
+}
+
+/**
+ * Returns -1 if there is no runtime component with that name
+*/
+int Registry::GetColumnComponentId(const std::string& name) const {
+    auto component = columnComponentIds.find(name);
+    return component != columnComponentIds.end() ? component->second : -1;
+}
+
+/**
+ * Returns nullptr if the id isn't a runtime component
+*/
+ColumnPool* Registry::GetColumnPool(int componentId) const {
+    if (componentId < 0 || componentId >= static_cast<int>(MAX_COMPONENTS) || !columnComponents.test(componentId)) {
+        return nullptr;
+    }
+    return static_cast<ColumnPool*>(componentPools[componentId].get());
+}
+
+/**
+ * Gives the entity a zeroed instance of the component and returns its index in the pool
+*/
+int Registry::AddColumnComponentToEntity(Entity entity, int componentId) {
+    ColumnPool* pool = GetColumnPool(componentId);
+    if (!pool) {
+        return -1;
+    }
+    TouchSignature(entity.GetId());
+    entityComponentSignatures[entity.GetId()].set(componentId);
+    return pool->Add(entity.GetId());
+}
+
+void Registry::RemoveColumnComponentFromEntity(Entity entity, int componentId) {
+    ColumnPool* pool = GetColumnPool(componentId);
+    if (!pool) {
+        return;
+    }
+    TouchSignature(entity.GetId());
+    entityComponentSignatures[entity.GetId()].set(componentId, false);
+    pool->Remove(entity.GetId());
+}
+
+bool Registry::EntityHasComponent(Entity entity, int componentId) const {
+    return componentId >= 0 && componentId < static_cast<int>(MAX_COMPONENTS) && entityComponentSignatures[entity.GetId()].test(componentId);
+}
+
 /**
  * We check the component signature of the given entity (that was slowly designed via
  * calls to Registry::AddComponentToEntity) and then we add this entity to all the systems
@@ -110,6 +255,12 @@ void Registry::AddEntityToSystems(Entity entity) {
     // Get Entity Comp. Sig.
     const auto entityComponentSignature = entityComponentSignatures[entityId];
 
+    // Joining a system counts as a change, the system has never seen the entity
+    if (entityId >= static_cast<int>(signatureTicks.size())) {
+        signatureTicks.resize(entityComponentSignatures.size(), 0);
+    }
+    signatureTicks[entityId] = changeTick;
+
     for (auto& systemEntry: systems) {
         // systemEntry = pair of (key, System*)
         std::shared_ptr<System> system = systemEntry.second;
@@ -128,10 +279,554 @@ void Registry::AddEntityToSystems(Entity entity) {
     }   
 }
 
+//////// Snapshots ////////
+
+static uint64_t GetSystemTypeHash(const std::type_index& type) {
+    return HashSnapshotType(type.name());
+}
+
+/**
+ * Writes the world as it is, including entities that are still waiting to be spawned,
+ * in the format described in Snapshot.h. Components are raw memory, the file is only
+ * meant to be loaded back by the same build.
+*/
+bool Registry::SaveSnapshot(const std::string& filePath) const {
+    static_assert(MAX_COMPONENTS <= 32, "Signatures are saved as 32 bits");
+    const double startMs = Profiler::NowMs();
+
+    SnapshotWriter writer;
+    SnapshotFileHeader header;
+    std::memcpy(header.magic, SNAPSHOT_FILE_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_FILE_VERSION;
+    header.entityCount = static_cast<uint32_t>(entityCount);
+    header.signatureCount = static_cast<uint32_t>(entityComponentSignatures.size());
+    header.spawnCount = static_cast<uint32_t>(entitiesToBeSpawned.size());
+    header.systemCount = static_cast<uint32_t>(systems.size());
+    header.poolCount = 0;
+    for (const auto& pool: componentPools) {
+        if (pool) {
+            header.poolCount++;
+        }
+    }
+    writer.Write(header);
+
+    // Ids and signatures are gathered into a scratch array and written as one block
+    std::vector<uint32_t> values(entityComponentSignatures.size());
+    for (size_t entityId = 0; entityId < entityComponentSignatures.size(); entityId++) {
+        values[entityId] = static_cast<uint32_t>(entityComponentSignatures[entityId].to_ulong());
+    }
+    writer.WriteBytes(values.data(), values.size() * sizeof(uint32_t));
+
+    values.clear();
+    for (const Entity& entity: entitiesToBeSpawned) {
+        values.push_back(static_cast<uint32_t>(entity.GetId()));
+    }
+    writer.WriteBytes(values.data(), values.size() * sizeof(uint32_t));
+
+    for (const auto& systemEntry: systems) {
+        const std::vector<Entity>& entities = systemEntry.second->GetSystemEntities();
+        writer.Write(GetSystemTypeHash(systemEntry.first));
+        writer.Write(static_cast<uint32_t>(entities.size()));
+        values.resize(entities.size());
+        for (size_t i = 0; i < entities.size(); i++) {
+            values[i] = static_cast<uint32_t>(entities[i].GetId());
+        }
+        writer.WriteBytes(values.data(), values.size() * sizeof(uint32_t));
+    }
+
+    for (size_t componentId = 0; componentId < componentPools.size(); componentId++) {
+        const std::shared_ptr<IPool>& pool = componentPools[componentId];
+        if (!pool) {
+            continue;
+        }
+        // Written as raw memory, the padding after componentId has to be zeroed too
+        SnapshotPoolHeader poolHeader;
+        std::memset(&poolHeader, 0, sizeof(poolHeader));
+        poolHeader.componentId = static_cast<int32_t>(componentId);
+        poolHeader.typeHash = pool->GetTypeHash();
+        poolHeader.size = 0;
+        const size_t headerOffset = writer.GetSize();
+        writer.Write(poolHeader);
+        pool->Save(writer);
+        poolHeader.size = writer.GetSize() - headerOffset - sizeof(poolHeader);
+        writer.Patch(headerOffset, poolHeader);
+    }
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        Logger::Err("Could not create snapshot " + filePath);
+        return false;
+    }
+    const std::vector<char>& buffer = writer.GetBuffer();
+    if (!file.write(buffer.data(), buffer.size())) {
+        Logger::Err("Could not write snapshot " + filePath);
+        return false;
+    }
+
+    Logger::Success("Snapshot of " + std::to_string(entityCount) + " entities saved to " + filePath + " (" + std::to_string(buffer.size() / 1024) + " KB, " + std::to_string(Profiler::NowMs() - startMs) + " ms)");
+    return true;
+}
+
+/**
+ * Replaces the world with a snapshot. Components go back into the pools that already
+ * exist, so the component types have to be registered (used at least once, or defined
+ * by the scripts) before loading. A pool the snapshot has no match for is skipped and
+ * its component is taken off every entity. The whole file is parsed before anything is
+ * replaced, nothing changes if it is bad.
+*/
+bool Registry::LoadSnapshot(const std::string& filePath) {
+    const double startMs = Profiler::NowMs();
+
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        Logger::Err("Could not open snapshot " + filePath);
+        return false;
+    }
+    std::vector<char> contents(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(contents.data(), contents.size())) {
+        Logger::Err("Could not read snapshot " + filePath);
+        return false;
+    }
+
+    SnapshotReader reader(contents.data(), contents.size());
+    SnapshotFileHeader header;
+    if (!reader.Read(header) ||
+        std::memcmp(header.magic, SNAPSHOT_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_FILE_VERSION ||
+        header.signatureCount < header.entityCount) {
+        Logger::Err(filePath + " is not a snapshot of this version");
+        return false;
+    }
+
+    // 1. Everything but the component data is read first, so a truncated file changes nothing
+    if (static_cast<uint64_t>(header.signatureCount) * sizeof(uint32_t) > reader.GetRemaining()) {
+        Logger::Err("Snapshot " + filePath + " is truncated");
+        return false;
+    }
+    std::vector<uint32_t> bits(header.signatureCount);
+    reader.ReadBytes(bits.data(), bits.size() * sizeof(uint32_t));
+    std::vector<Signature> signatures(bits.begin(), bits.end());
+
+    std::vector<int32_t> spawnIds(header.spawnCount);
+    bool complete = reader.ReadBytes(spawnIds.data(), spawnIds.size() * sizeof(int32_t));
+
+    std::vector<std::pair<uint64_t, std::vector<int32_t>>> systemEntities(header.systemCount);
+    for (auto& systemRecord: systemEntities) {
+        uint32_t count = 0;
+        complete = complete && reader.Read(systemRecord.first) && reader.Read(count) && static_cast<uint64_t>(count) * sizeof(int32_t) <= reader.GetRemaining();
+        if (!complete) {
+            break;
+        }
+        systemRecord.second.resize(count);
+        reader.ReadBytes(systemRecord.second.data(), count * sizeof(int32_t));
+    }
+
+    std::vector<std::pair<SnapshotPoolHeader, SnapshotReader>> poolRecords;
+    for (uint32_t i = 0; complete && i < header.poolCount; i++) {
+        SnapshotPoolHeader poolHeader;
+        SnapshotReader poolReader(nullptr, 0);
+        complete = reader.Read(poolHeader) && reader.Take(poolHeader.size, poolReader);
+        poolRecords.push_back(std::make_pair(poolHeader, poolReader));
+    }
+
+    for (int32_t entityId: spawnIds) {
+        complete = complete && entityId >= 0 && entityId < static_cast<int32_t>(header.signatureCount);
+    }
+    for (const auto& systemRecord: systemEntities) {
+        for (int32_t entityId: systemRecord.second) {
+            complete = complete && entityId >= 0 && entityId < static_cast<int32_t>(header.signatureCount);
+        }
+    }
+    if (!complete) {
+        Logger::Err("Snapshot " + filePath + " is truncated");
+        return false;
+    }
+
+    // 2. Component data is parsed next to the pools, a corrupted pool fails the whole load
+    std::vector<IPool*> loadedPools;
+    for (auto& poolRecord: poolRecords) {
+        const SnapshotPoolHeader& poolHeader = poolRecord.first;
+        const int componentId = poolHeader.componentId;
+        const bool known = componentId >= 0 && componentId < static_cast<int>(componentPools.size()) && componentPools[componentId];
+        if (!known || componentPools[componentId]->GetTypeHash() != poolHeader.typeHash) {
+            Logger::Err("Snapshot component of ID = " + std::to_string(componentId) + " doesn't match any pool, skipping it");
+            if (componentId >= 0 && componentId < static_cast<int>(MAX_COMPONENTS)) {
+                for (Signature& signature: signatures) {
+                    signature.reset(componentId);
+                }
+            }
+        } else if (std::find(loadedPools.begin(), loadedPools.end(), componentPools[componentId].get()) != loadedPools.end() ||
+                   !componentPools[componentId]->Load(poolRecord.second)) {
+            Logger::Err("Snapshot " + filePath + " has a corrupted component of ID = " + std::to_string(componentId));
+            return false;
+        } else {
+            loadedPools.push_back(componentPools[componentId].get());
+        }
+    }
+
+    // 3. Nothing can fail from here on, the parsed pools take over
+    ClearRollbackHistory();
+    for (IPool* pool: loadedPools) {
+        pool->CommitLoad();
+    }
+
+    // 4. Entities and systems
+    entityCount = static_cast<int>(header.entityCount);
+    entityComponentSignatures.swap(signatures);
+    signatureHash.Clear();
+    signatureTicks.assign(entityComponentSignatures.size(), changeTick);
+    // `signatures` holds the ones from before the load now
+    QueueSignatureChanges(signatures);
+    entitiesToBeKilled.clear();
+    entitiesToBeSpawned.clear();
+    for (int32_t entityId: spawnIds) {
+        Entity entity(entityId);
+        entity.registry = this;
+        entitiesToBeSpawned.insert(entity);
+    }
+
+    for (auto& systemEntry: systems) {
+        System& system = *systemEntry.second;
+        const Signature& systemSignature = system.GetComponentSignature();
+        system.ClearSystemEntities();
+
+        const uint64_t typeHash = GetSystemTypeHash(systemEntry.first);
+        auto systemRecord = std::find_if(systemEntities.begin(), systemEntities.end(), [typeHash](const std::pair<uint64_t, std::vector<int32_t>>& record) {
+            return record.first == typeHash;
+        });
+
+        if (systemRecord != systemEntities.end()) {
+            // Saved order, the systems walk their entities in it
+            for (int32_t entityId: systemRecord->second) {
+                if ((entityComponentSignatures[entityId] & systemSignature) == systemSignature) {
+                    Entity entity(entityId);
+                    entity.registry = this;
+                    system.AddEntityToSystem(entity);
+                }
+            }
+        } else {
+            // A system added after the snapshot was taken
+            for (int entityId = 0; entityId < entityCount; entityId++) {
+                Entity entity(entityId);
+                if (entitiesToBeSpawned.count(entity) == 0 && (entityComponentSignatures[entityId] & systemSignature) == systemSignature) {
+                    entity.registry = this;
+                    system.AddEntityToSystem(entity);
+                }
+            }
+        }
+    }
+
+    Logger::Success("Snapshot of " + std::to_string(entityCount) + " entities loaded from " + filePath + " (" + std::to_string(Profiler::NowMs() - startMs) + " ms)");
+    return true;
+}
+
+//////// Rollback ////////
+
+void Registry::TouchSignature(int entityId) {
+    signatureHistory.Touch(entityComponentSignatures, entityId);
+    signatureHash.Touch(entityId);
+    if (entityId >= static_cast<int>(signatureTicks.size())) {
+        signatureTicks.resize(entityComponentSignatures.size(), 0);
+    }
+    signatureTicks[entityId] = changeTick;
+}
+
+// New pools stamp with the current tick and, in the middle of a frame, start recording right away
+void Registry::SetUpPool(int componentId) {
+    componentPools[componentId]->SetChangeTick(changeTick);
+    if (rollbackRecording) {
+        componentPools[componentId]->BeginFrame(rollbackFrame);
+    }
+}
+
+/**
+ * Keeps the entity bookkeeping and the entities of every system as they are before the
+ * first spawn or kill of the frame. Those are rare, so this is a full copy.
+*/
+void Registry::SaveStructureForRollback() {
+    if (!rollbackRecording) {
+        return;
+    }
+    RollbackStructure& structure = rollbackStructures[rollbackFrame % ROLLBACK_FRAMES];
+    if (structure.frame == rollbackFrame) {
+        return;
+    }
+    structure.frame = rollbackFrame;
+    structure.entityCount = entityCount;
+    structure.entitiesToBeSpawned = entitiesToBeSpawned;
+    structure.entitiesToBeKilled = entitiesToBeKilled;
+    structure.systemEntities.clear();
+    for (auto& systemEntry: systems) {
+        structure.systemEntities.push_back(std::make_pair(systemEntry.second, systemEntry.second->GetSystemEntities()));
+    }
+}
+
+/**
+ * Call at the start of every frame, before anything changes. What gets written from
+ * here on is recorded as `frame`, see RollbackHistory. Skipping a frame number starts
+ * the history over.
+*/
+void Registry::BeginFrame(int frame) {
+    if (rollbackStructures.empty()) {
+        rollbackStructures.resize(ROLLBACK_FRAMES);
+    }
+    if (rollbackFirstFrame < 0 || frame != rollbackFrame + 1) {
+        rollbackFirstFrame = frame;
+    }
+    rollbackFrame = frame;
+    rollbackRecording = true;
+    rollbackStructures[frame % ROLLBACK_FRAMES].frame = -1;
+
+    signatureHistory.BeginFrame(frame, entityComponentSignatures.size());
+    for (auto& pool: componentPools) {
+        if (pool) {
+            pool->BeginFrame(frame);
+        }
+    }
+}
+
+int Registry::GetFrame() const {
+    return rollbackFrame;
+}
+
+int Registry::GetOldestRollbackFrame() const {
+    if (rollbackFirstFrame < 0) {
+        return -1;
+    }
+    return std::max(rollbackFirstFrame, rollbackFrame - ROLLBACK_FRAMES + 1);
+}
+
+/**
+ * Puts the world back the way it was when `frame` began: components, signatures, entities
+ * and system memberships. Only the pages written since are copied. Run the frames again
+ * (BeginFrame(frame), the systems, BeginFrame(frame + 1)...) to re-simulate from there.
+ * State outside the Registry (the Lua scripts, the event queues) is not rolled back.
+*/
+bool Registry::Rollback(int frame) {
+    const int oldest = GetOldestRollbackFrame();
+    if (oldest < 0 || frame < oldest || frame > rollbackFrame) {
+        Logger::Err("Can't roll back to frame " + std::to_string(frame) + ", the history goes from frame " + std::to_string(oldest) + " to " + std::to_string(rollbackFrame));
+        return false;
+    }
+
+    // Observers are told about the components the rollback adds back or takes away
+    std::vector<Signature> signaturesBefore;
+    if ((observedAdds | observedRemoves).any()) {
+        signaturesBefore = entityComponentSignatures;
+    }
+
+    signatureHistory.Rollback(frame, entityComponentSignatures, [this](size_t first, size_t count) {
+        signatureHash.TouchRange(first, count);
+        if (first + count > signatureTicks.size()) {
+            signatureTicks.resize(first + count, 0);
+        }
+        std::fill(signatureTicks.begin() + first, signatureTicks.begin() + first + count, changeTick);
+    });
+    for (auto& pool: componentPools) {
+        if (pool) {
+            pool->Rollback(frame);
+        }
+    }
+
+    // Newest first, the oldest record left applied is how the frame began
+    for (int f = rollbackFrame; f >= frame; f--) {
+        RollbackStructure& structure = rollbackStructures[f % ROLLBACK_FRAMES];
+        if (structure.frame != f) {
+            continue;
+        }
+        entityCount = structure.entityCount;
+        entitiesToBeSpawned = structure.entitiesToBeSpawned;
+        entitiesToBeKilled = structure.entitiesToBeKilled;
+        for (auto& systemRecord: structure.systemEntities) {
+            systemRecord.first->ClearSystemEntities();
+            for (Entity entity: systemRecord.second) {
+                systemRecord.first->AddEntityToSystem(entity);
+                if (entity.GetId() < static_cast<int>(signatureTicks.size())) {
+                    signatureTicks[entity.GetId()] = changeTick;
+                }
+            }
+        }
+        structure.frame = -1;
+    }
+
+    if ((observedAdds | observedRemoves).any()) {
+        QueueSignatureChanges(signaturesBefore);
+    }
+
+    Logger::Log("Rolled back " + std::to_string(rollbackFrame - frame + 1) + " frames to frame " + std::to_string(frame));
+    rollbackFrame = frame - 1;
+    rollbackRecording = false;
+    return true;
+}
+
+void Registry::ClearRollbackHistory() {
+    signatureHistory.Clear();
+    for (auto& pool: componentPools) {
+        if (pool) {
+            pool->ClearHistory();
+        }
+    }
+    rollbackStructures.clear();
+    rollbackFrame = -1;
+    rollbackFirstFrame = -1;
+    rollbackRecording = false;
+}
+
+//////// Checksum ////////
+
+/**
+ * Combines the entity count, the signatures and the hash of every pool. Each part only
+ * rehashes what was written since the last call, so calling it every frame costs about
+ * as much as the frame changed. The system memberships follow from the rest and are
+ * left out.
+*/
+uint64_t Registry::GetChecksum() {
+    uint64_t checksum = MixStateHash(static_cast<uint64_t>(entityCount));
+    checksum = MixStateHash(checksum ^ static_cast<uint64_t>(entitiesToBeSpawned.size()));
+
+    const uint64_t signaturesHash = signatureHash.Get(entityComponentSignatures.size(), [this](size_t first, size_t count) {
+        uint32_t bits[STATE_HASH_PAGE_SIZE];
+        for (size_t i = 0; i < count; i++) {
+            bits[i] = static_cast<uint32_t>(entityComponentSignatures[first + i].to_ulong());
+        }
+        return HashStateBytes(bits, count * sizeof(uint32_t));
+    });
+    checksum = MixStateHash(checksum ^ signaturesHash);
+
+    for (size_t componentId = 0; componentId < componentPools.size(); componentId++) {
+        if (componentPools[componentId]) {
+            checksum = MixStateHash(checksum ^ (componentPools[componentId]->GetStateHash() + componentId));
+        }
+    }
+    return checksum;
+}
+
+//////// Observers ////////
+
+void Registry::AddObserver(int componentId, bool onAdd, ComponentObserver observer) {
+    if (componentId >= static_cast<int>(componentObservers.size())) {
+        componentObservers.resize(componentId + 1);
+    }
+    if (onAdd) {
+        componentObservers[componentId].onAdd.push_back(observer);
+        observedAdds.set(componentId);
+    } else {
+        componentObservers[componentId].onRemove.push_back(observer);
+        observedRemoves.set(componentId);
+    }
+}
+
+void Registry::RemoveObservers(void* owner) {
+    auto isOwner = [owner](const ComponentObserver& observer) {
+        return observer.owner == owner;
+    };
+    for (size_t componentId = 0; componentId < componentObservers.size(); componentId++) {
+        ComponentObservers& observers = componentObservers[componentId];
+        observers.onAdd.erase(std::remove_if(observers.onAdd.begin(), observers.onAdd.end(), isOwner), observers.onAdd.end());
+        observers.onRemove.erase(std::remove_if(observers.onRemove.begin(), observers.onRemove.end(), isOwner), observers.onRemove.end());
+        if (observers.onAdd.empty()) {
+            observedAdds.reset(componentId);
+            observers.added.clear();
+        }
+        if (observers.onRemove.empty()) {
+            observedRemoves.reset(componentId);
+            observers.removed.clear();
+        }
+    }
+}
+
+void Registry::QueueComponentAdded(int componentId, Entity entity) {
+    componentObservers[componentId].added.push_back(entity);
+}
+
+void Registry::QueueComponentRemoved(int componentId, Entity entity) {
+    componentObservers[componentId].removed.push_back(entity);
+}
+
+/**
+ * For changes that don't go through Add/RemoveComponent (rollback, snapshots): compares
+ * the signatures from before with the ones now and queues the difference for observers.
+*/
+void Registry::QueueSignatureChanges(const std::vector<Signature>& before) {
+    const Signature observed = observedAdds | observedRemoves;
+    if (observed.none()) {
+        return;
+    }
+    const size_t count = std::max(before.size(), entityComponentSignatures.size());
+    for (size_t entityId = 0; entityId < count; entityId++) {
+        const Signature previous = entityId < before.size() ? before[entityId] : Signature();
+        const Signature current = entityId < entityComponentSignatures.size() ? entityComponentSignatures[entityId] : Signature();
+        const Signature changed = (previous ^ current) & observed;
+        if (changed.none()) {
+            continue;
+        }
+
+        Entity entity(static_cast<int>(entityId));
+        entity.registry = this;
+        for (size_t componentId = 0; componentId < MAX_COMPONENTS; componentId++) {
+            if (!changed.test(componentId)) {
+                continue;
+            }
+            if (current.test(componentId) && observedAdds.test(componentId)) {
+                QueueComponentAdded(static_cast<int>(componentId), entity);
+            } else if (!current.test(componentId) && observedRemoves.test(componentId)) {
+                QueueComponentRemoved(static_cast<int>(componentId), entity);
+            }
+        }
+    }
+}
+
+/**
+ * Hands the queued entities to the observers as one batch. Only what still holds is
+ * reported: an entity is reported added if it has the component now and removed if it
+ * doesn't, once, whatever happened to it in between. Whatever the observers add or
+ * remove meanwhile is reported at the next Update().
+*/
+void Registry::NotifyObservers(std::vector<Entity>& queue, const std::vector<ComponentObserver>& observers, int componentId, bool present) {
+    if (queue.empty()) {
+        return;
+    }
+    observerBatch.swap(queue);
+
+    std::sort(observerBatch.begin(), observerBatch.end());
+    observerBatch.erase(std::unique(observerBatch.begin(), observerBatch.end()), observerBatch.end());
+    observerBatch.erase(std::remove_if(observerBatch.begin(), observerBatch.end(), [this, componentId, present](Entity entity) {
+        const bool hasComponent = entity.GetId() < static_cast<int>(entityComponentSignatures.size()) && entityComponentSignatures[entity.GetId()].test(componentId);
+        return hasComponent != present;
+    }), observerBatch.end());
+
+    if (!observerBatch.empty()) {
+        for (const ComponentObserver& observer: observers) {
+            observer.callback(observer.owner, observerBatch);
+        }
+    }
+    observerBatch.clear();
+}
+
+//////// Change ticks ////////
+
+uint32_t Registry::AdvanceChangeTick() {
+    const uint32_t tick = changeTick++;
+    for (auto& pool: componentPools) {
+        if (pool) {
+            pool->SetChangeTick(changeTick);
+        }
+    }
+    return tick;
+}
+
+uint32_t Registry::GetSignatureChangeTick(Entity entity) const {
+    return entity.GetId() < static_cast<int>(signatureTicks.size()) ? signatureTicks[entity.GetId()] : 0;
+}
+
 /**
  * Create or Destroy Entities that are waiting on the queues
 */
 void Registry::Update() {
+    if (!entitiesToBeSpawned.empty() || !entitiesToBeKilled.empty()) {
+        SaveStructureForRollback();
+    }
 
     // Waiting to be created
     for (auto entity: entitiesToBeSpawned) {
@@ -144,4 +839,11 @@ void Registry::Update() {
     for (auto entity: entitiesToBeKilled) {
 
     }
+
+    // Removals first, so an entity that lost a component and got a new one ends up added
+    for (size_t componentId = 0; componentId < componentObservers.size(); componentId++) {
+        ComponentObservers& observers = componentObservers[componentId];
+        NotifyObservers(observers.removed, observers.onRemove, static_cast<int>(componentId), false);
+        NotifyObservers(observers.added, observers.onAdd, static_cast<int>(componentId), true);
+    }
 }
\ No newline at end of file
@@ -8,7 +8,9 @@
 #include <unordered_set>
 #include <typeindex>
 #include <memory>
+#include <algorithm>
 #include "Pool.h"
+#include "ColumnPool.h"
 #include "../Logger/Logger.h"
 
 // Registry forward decaration to be used by Entity
@@ -57,6 +59,8 @@ class Entity {
         template <typename TComponent> void RemoveComponent();
         template <typename TComponent> bool HasComponent() const;
         template <typename TComponent> TComponent& GetComponent() const;
+        // Same as GetComponent for code that only reads, it doesn't count as a change for rollback
+        template <typename TComponent> const TComponent& ReadComponent() const;
 
 };
 
@@ -67,6 +71,13 @@ class Entity {
 struct IComponent {
     protected:
         static int nextId;
+
+    public:
+        // Id for a component type defined at runtime, -1 once all the Signature bits are taken
+        static int ReserveId();
+        // Id for a C++ component type. There is no going on without one, so it stops the
+        // game with an error once scripts and code together took all the Signature bits
+        static int ReserveTypeId(const char* typeName);
 };
 
 // We do this whole IComponent and Template Component so that we can have
@@ -82,7 +93,7 @@ class Component: public IComponent {
         // We use `static` here to retain the value across all calls of all instances
         // of the same type of Component
         static int GetId() {
-            static auto id = nextId++;
+            static auto id = ReserveTypeId(typeid(TComponent).name());
             return id;
         }
 };
@@ -95,6 +106,10 @@ class System {
         Signature componentSignature;
         std::vector<Entity> entities;
 
+        // Last change tick GetChangedEntities() looked at, and what it returned
+        uint32_t changedSinceTick = 0;
+        std::vector<Entity> changedEntities;
+
     public:
         System() = default; // Default constructor
         ~System() = default; // Default destructor
@@ -102,11 +117,15 @@ class System {
         //////// Entities ////////
         void AddEntityToSystem(Entity entity);
         void RemoveEntityFromSystem(Entity entity);
+        void ClearSystemEntities();
         const std::vector<Entity>& GetSystemEntities() const;
+        template <typename ...TComponents> const std::vector<Entity>& GetChangedEntities();
 
         //////// Components ////////
         const Signature& GetComponentSignature() const;
         template <typename TComponent> void RequireComponent();
+        // For components registered at runtime
+        void RequireComponent(int componentId);
 };
 
 /**
@@ -153,6 +172,81 @@ class Registry {
         ////////////////
         std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
 
+        ////////////////////////
+        // Runtime components //
+        ////////////////////////
+        // Components defined while the game runs (by scripts), they live in ColumnPools
+        std::unordered_map<std::string, int> columnComponentIds;
+        Signature columnComponents;
+
+        //////////////
+        // Rollback //
+        //////////////
+        // What entities and system memberships looked like before the first change in a
+        // frame, only kept for frames that spawn or kill entities
+        struct RollbackStructure {
+            int frame = -1;
+            int entityCount = 0;
+            std::set<Entity> entitiesToBeSpawned;
+            std::set<Entity> entitiesToBeKilled;
+            std::vector<std::pair<std::shared_ptr<System>, std::vector<Entity>>> systemEntities;
+        };
+
+        int rollbackFrame = -1;
+        int rollbackFirstFrame = -1;
+        bool rollbackRecording = false;
+        RollbackHistory<Signature> signatureHistory;
+        StateHash signatureHash;
+        std::vector<RollbackStructure> rollbackStructures;
+
+        //////////////////
+        // Change ticks //
+        //////////////////
+        // Writes are stamped with the current tick, in the pools and here for the signatures
+        uint32_t changeTick = 1;
+        // [entityId => tick of the last change to its signature or to the systems it is in]
+        std::vector<uint32_t> signatureTicks;
+
+        ///////////////
+        // Observers //
+        ///////////////
+        // Subscribers to a component being added or removed, called like the EventBus calls
+        // its subscribers, and the entities waiting for the next Update() to report them
+        struct ComponentObserver {
+            void* owner;
+            void (*callback)(void* owner, const std::vector<Entity>& entities);
+        };
+
+        struct ComponentObservers {
+            std::vector<ComponentObserver> onAdd;
+            std::vector<ComponentObserver> onRemove;
+            std::vector<Entity> added;
+            std::vector<Entity> removed;
+        };
+
+        // [componentId => observers]
+        std::vector<ComponentObservers> componentObservers;
+        // Components with at least one observer, nothing is queued for the others
+        Signature observedAdds;
+        Signature observedRemoves;
+        // What is being reported, swapped with the queue so observers can queue more meanwhile
+        std::vector<Entity> observerBatch;
+
+        template <typename TOwner, void (TOwner::*Callback)(const std::vector<Entity>&)>
+        static void ObserverTrampoline(void* owner, const std::vector<Entity>& entities) {
+            (static_cast<TOwner*>(owner)->*Callback)(entities);
+        }
+
+        void AddObserver(int componentId, bool onAdd, ComponentObserver observer);
+        void QueueComponentAdded(int componentId, Entity entity);
+        void QueueComponentRemoved(int componentId, Entity entity);
+        void QueueSignatureChanges(const std::vector<Signature>& before);
+        void NotifyObservers(std::vector<Entity>& queue, const std::vector<ComponentObserver>& observers, int componentId, bool present);
+
+        void SaveStructureForRollback();
+        void TouchSignature(int entityId);
+        void SetUpPool(int componentId);
+
 
     public:
         Registry();
@@ -167,10 +261,60 @@ class Registry {
         template <typename TComponent> void RemoveComponentFromEntity(Entity entity);
         template <typename TComponent> bool EntityHasComponent(Entity entity) const;
         template <typename TComponent> TComponent& GetComponentFromEntity(Entity entity) const;
+        template <typename TComponent> const TComponent& ReadComponentFromEntity(Entity entity) const;
+
+        //////// Bulk ////////
+        // For loading whole scenes: no per-entity/component logging and pools grow once
+        void SpawnEntities(int count, std::vector<Entity>& spawned);
+        template <typename TComponent> void AddComponentsToEntities(const std::vector<Entity>& entities, const std::vector<TComponent>& components);
+
+        //////// Runtime components ////////
+        int RegisterColumnComponent(const std::string& name, const std::vector<ColumnField>& fields);
+        int GetColumnComponentId(const std::string& name) const;
+        ColumnPool* GetColumnPool(int componentId) const;
+        int AddColumnComponentToEntity(Entity entity, int componentId);
+        void RemoveColumnComponentFromEntity(Entity entity, int componentId);
+        bool EntityHasComponent(Entity entity, int componentId) const;
 
         //////// Entities-Systems ////////
         void AddEntityToSystems(Entity entity);
 
+        //////// Snapshots ////////
+        // The whole world (entities, components, system memberships) to and from a file
+        bool SaveSnapshot(const std::string& filePath) const;
+        bool LoadSnapshot(const std::string& filePath);
+
+        //////// Rollback ////////
+        // Records the changes made from now on as `frame`, frames have to come one after the other
+        void BeginFrame(int frame);
+        int GetFrame() const;
+        // Oldest frame Rollback() can go back to, -1 if there is none
+        int GetOldestRollbackFrame() const;
+        bool Rollback(int frame);
+        void ClearRollbackHistory();
+
+        //////// Checksum ////////
+        // Hash of the whole world, equal in two runs only if they ended up in the same state
+        uint64_t GetChecksum();
+
+        //////// Change ticks ////////
+        // Returns the current tick and moves on to the next one, so what is written from
+        // now on is told apart from what was written before
+        uint32_t AdvanceChangeTick();
+        // Ticks of the last write to the entity's component and of the last change to its
+        // signature or systems, 0 if there was none
+        template <typename TComponent> uint32_t GetComponentChangeTick(Entity entity) const;
+        uint32_t GetSignatureChangeTick(Entity entity) const;
+
+        //////// Observers ////////
+        // The callback gets, at the next Update(), every entity the component was added to
+        // (or removed from) since the last one:
+        //   registry->OnAdd<BoxColliderComponent, MySystem, &MySystem::OnCollidersAdded>(this);
+        template <typename TComponent, typename TOwner, void (TOwner::*Callback)(const std::vector<Entity>&)> void OnAdd(TOwner* owner);
+        template <typename TComponent, typename TOwner, void (TOwner::*Callback)(const std::vector<Entity>&)> void OnRemove(TOwner* owner);
+        // Removes every observer of the owner, for any component
+        void RemoveObservers(void* owner);
+
         //////// Systems ////////
         template <typename TSystem, typename ...TArgs> void AddSystem(TArgs&& ...args);
         template <typename TSystem> void RemoveSystem();
@@ -180,7 +324,8 @@ class Registry {
         /**
          * Here is where we actually spawn/kill entities that are waiting to be added/removed
          * We want to wait until the end of the frame to these updates so that we don't confuse
-         * the Systems with things changing in the middle of the currentframe logic
+         * the Systems with things changing in the middle of the currentframe logic.
+         * Then the component observers get what was added and removed since the last call.
         */
         void Update();
 
@@ -213,6 +358,7 @@ void Registry::AddComponentToEntity(Entity entity, TArgs&& ...args) {
     // 1B. Check if the component doesn't have an intialized pool yet
     if (!componentPools[componentId]) {
         componentPools[componentId] = std::make_shared<Pool<TComponent>>();
+        SetUpPool(componentId);
     }
 
     // 1C. Get ComponentPool for the Component type
@@ -230,6 +376,11 @@ void Registry::AddComponentToEntity(Entity entity, TArgs&& ...args) {
     componentPool->Set(entityId, newComponent);
 
     /// 2. Set the component Signature of the Entity ///
+    // Replacing a component the entity already has isn't an add for the observers
+    if (observedAdds.test(componentId) && !entityComponentSignatures[entityId].test(componentId)) {
+        QueueComponentAdded(componentId, entity);
+    }
+    TouchSignature(entityId);
     entityComponentSignatures[entityId].set(componentId);
 
     Logger::Log("Component of ID = " + std::to_string(Component<TComponent>::GetId()) + "  has been added to Entity of ID = " + std::to_string(entity.GetId()));
@@ -246,7 +397,12 @@ void Registry::RemoveComponentFromEntity(Entity entity) {
     const auto componentId = Component<TComponent>::GetId();
     const auto entityId = entity.GetId();
     
+    if (observedRemoves.test(componentId) && entityComponentSignatures[entityId].test(componentId)) {
+        QueueComponentRemoved(componentId, entity);
+    }
+
     // Turn off the bit for the component signature of the entity
+    TouchSignature(entityId);
     entityComponentSignatures[entityId].set(componentId, false);
 
     Logger::Log("Component of ID = " + std::to_string(Component<TComponent>::GetId()) + "  has been removed from Entity of ID = " + std::to_string(entity.GetId()));
@@ -263,7 +419,7 @@ bool Registry::EntityHasComponent(Entity entity) const {
     const auto entityId = entity.GetId();
 
     // Check on the Component Signature for whether the entity has a component
-    return entityComponentSignatures[entityId].test(componentId);
+    return entityId >= 0 && entityId < static_cast<int>(entityComponentSignatures.size()) && entityComponentSignatures[entityId].test(componentId);
 };
 
 /**
@@ -282,6 +438,67 @@ TComponent& Registry::GetComponentFromEntity(Entity entity) const {
     return componentPool->Get(entityId);
 };
 
+/**
+ * Read only version of GetComponentFromEntity
+*/
+template <typename TComponent>
+const TComponent& Registry::ReadComponentFromEntity(Entity entity) const {
+    const auto componentId = Component<TComponent>::GetId();
+    const Pool<TComponent>* componentPool = static_cast<const Pool<TComponent>*>(componentPools[componentId].get());
+    return componentPool->Read(entity.GetId());
+}
+
+
+template <typename TComponent>
+uint32_t Registry::GetComponentChangeTick(Entity entity) const {
+    const auto componentId = Component<TComponent>::GetId();
+    if (componentId >= static_cast<int>(componentPools.size()) || !componentPools[componentId]) {
+        return 0;
+    }
+    const Pool<TComponent>* componentPool = static_cast<const Pool<TComponent>*>(componentPools[componentId].get());
+    return componentPool->GetChangeTick(entity.GetId());
+}
+
+
+/**
+ * Same as AddComponentToEntity for a whole batch, entities[i] gets components[i].
+ * The pool is resized at most once and the batch is logged as a single line.
+*/
+template <typename TComponent>
+void Registry::AddComponentsToEntities(const std::vector<Entity>& entities, const std::vector<TComponent>& components) {
+    const auto componentId = Component<TComponent>::GetId();
+    const int count = static_cast<int>(std::min(entities.size(), components.size()));
+
+    if (componentId >= static_cast<int>(componentPools.size())) {
+        componentPools.resize(componentId + 1, nullptr);
+    }
+    if (!componentPools[componentId]) {
+        componentPools[componentId] = std::make_shared<Pool<TComponent>>();
+        SetUpPool(componentId);
+    }
+    std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
+
+    int maxEntityId = -1;
+    for (int i = 0; i < count; i++) {
+        maxEntityId = std::max(maxEntityId, entities[i].GetId());
+    }
+    if (maxEntityId >= componentPool->GetSize()) {
+        componentPool->Resize(maxEntityId + 1);
+    }
+
+    for (int i = 0; i < count; i++) {
+        const int entityId = entities[i].GetId();
+        componentPool->Set(entityId, components[i]);
+        if (observedAdds.test(componentId) && !entityComponentSignatures[entityId].test(componentId)) {
+            QueueComponentAdded(componentId, entities[i]);
+        }
+        TouchSignature(entityId);
+        entityComponentSignatures[entityId].set(componentId);
+    }
+
+    Logger::Log(std::to_string(count) + " components of ID = " + std::to_string(componentId) + " have been added");
+}
+
 
 //////// Systems ////////
 /**
@@ -332,6 +549,47 @@ TSystem& Registry::GetSystem() const {
     return *(std::static_pointer_cast<TSystem>(systemEntry->second));
 }
 
+//////// Observers ////////
+
+template <typename TComponent, typename TOwner, void (TOwner::*Callback)(const std::vector<Entity>&)>
+void Registry::OnAdd(TOwner* owner) {
+    AddObserver(Component<TComponent>::GetId(), true, { owner, &ObserverTrampoline<TOwner, Callback> });
+}
+
+template <typename TComponent, typename TOwner, void (TOwner::*Callback)(const std::vector<Entity>&)>
+void Registry::OnRemove(TOwner* owner) {
+    AddObserver(Component<TComponent>::GetId(), false, { owner, &ObserverTrampoline<TOwner, Callback> });
+}
+
+//////// System change tracking ////////
+
+/**
+ * Entities of the system that had any of TComponents written (through GetComponent or by
+ * adding it), their signature changed or that joined the system since the last call,
+ * everything on the first call. Rolled back and loaded components count as written.
+ * Each system only sees its own changes, so call it once per update and keep the result
+ * for the whole update.
+ * Components read with ReadComponent are not stamped, write through them only with
+ * GetComponent or this misses the change.
+*/
+template <typename ...TComponents>
+const std::vector<Entity>& System::GetChangedEntities() {
+    changedEntities.clear();
+    if (entities.empty()) {
+        return changedEntities;
+    }
+    Registry* registry = entities.front().registry;
+    const uint32_t sinceTick = changedSinceTick;
+    changedSinceTick = registry->AdvanceChangeTick();
+
+    for (Entity entity: entities) {
+        if (registry->GetSignatureChangeTick(entity) > sinceTick || ((registry->GetComponentChangeTick<TComponents>(entity) > sinceTick) || ...)) {
+            changedEntities.push_back(entity);
+        }
+    }
+    return changedEntities;
+}
+
 template <typename TComponent, typename ...TArgs> void Entity::AddComponent(TArgs&& ...args) {
     // Funny enough passing an integer as the first param to AddComponentToEntity() (or any of the similar methods) 
     // Like so: registry->AddComponentToEntity<TComponent>(123, std::forward<TArgs>(args)...); doesn't result
@@ -349,5 +607,8 @@ template <typename TComponent> bool Entity::HasComponent() const {
 template <typename TComponent> TComponent& Entity::GetComponent() const {
     return registry->GetComponentFromEntity<TComponent>(*this);
 }
+template <typename TComponent> const TComponent& Entity::ReadComponent() const {
+    return registry->ReadComponentFromEntity<TComponent>(*this);
+}
 
 #endif
\ No newline at end of file
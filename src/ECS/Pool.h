@@ -1,4 +1,14 @@
+#ifndef POOL_H
+#define POOL_H
+
 #include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <typeinfo>
+#include <type_traits>
+#include "Snapshot.h"
+#include "RollbackHistory.h"
+#include "StateHash.h"
 
 ////////////////////////////////////////////////////////////////////////////
 /////////////////////////////// Pools //////////////////////////////////////
@@ -10,12 +20,71 @@
 class IPool {
     public:
         virtual ~IPool() {}
+
+        //////// Snapshots ////////
+        // Identifies the stored type (and its layout), a pool only loads what a pool of the same type saved
+        virtual uint64_t GetTypeHash() const = 0;
+        virtual void Save(SnapshotWriter& writer) const = 0;
+        // Only parses what Save() wrote, the pool keeps its contents until CommitLoad()
+        virtual bool Load(SnapshotReader& reader) = 0;
+        // Replaces the contents with what the last successful Load() parsed
+        virtual void CommitLoad() = 0;
+
+        //////// Rollback ////////
+        // See RollbackHistory, driven by Registry::BeginFrame/Rollback
+        virtual void BeginFrame(int frame) = 0;
+        virtual void Rollback(int frame) = 0;
+        virtual void ClearHistory() = 0;
+
+        //////// State hash ////////
+        // Hash of everything in the pool, only what was written since the last call is rehashed
+        virtual uint64_t GetStateHash() = 0;
+
+        //////// Change ticks ////////
+        // Tick that writes are stamped with from now on, see Registry::AdvanceChangeTick
+        virtual void SetChangeTick(uint32_t /* tick */) {}
 };
 
 template <typename T>
 class Pool : public IPool {
     private:
         std::vector<T> data;
+        // Parsed by Load(), waiting for CommitLoad()
+        std::vector<T> loadedData;
+        RollbackHistory<T> history;
+        StateHash stateHash;
+        // Components that aren't trivially copyable are serialized in here to be hashed
+        SnapshotWriter hashScratch;
+        // [index => tick of the last write], compared against by System::GetChangedEntities
+        std::vector<uint32_t> changeTicks;
+        uint32_t changeTick = 0;
+
+        void Stamp(size_t index) {
+            if (index >= changeTicks.size()) {
+                changeTicks.resize(data.size(), 0);
+            }
+            changeTicks[index] = changeTick;
+        }
+
+        void StampRange(size_t first, size_t count) {
+            if (first + count > changeTicks.size()) {
+                changeTicks.resize(std::max(data.size(), first + count), 0);
+            }
+            std::fill(changeTicks.begin() + first, changeTicks.begin() + first + count, changeTick);
+        }
+
+        uint64_t HashComponents(size_t first, size_t count) {
+            if constexpr (std::is_trivially_copyable<T>::value) {
+                return HashStateBytes(data.data() + first, count * sizeof(T));
+            } else {
+                hashScratch.Clear();
+                for (size_t i = first; i < first + count; i++) {
+                    SaveComponent(hashScratch, data[i]);
+                }
+                return HashStateBytes(hashScratch.GetBuffer().data(), hashScratch.GetSize());
+            }
+        }
+
     public:
         Pool(int size = 100) {
             data.resize(size);
@@ -37,21 +106,127 @@ class Pool : public IPool {
 
         void Clear() {
             data.clear();
+            history.Clear();
+            stateHash.Clear();
+            changeTicks.clear();
         }
 
         void Add(T object) {
             data.push_back(object);
+            Stamp(data.size() - 1);
         }
 
+        // Writes go through Set, Get and [], which save the element's page for rollback
+        // first, mark it for rehashing and stamp it with the current change tick
         void Set(int index, T object) {
+            history.Touch(data, index);
+            stateHash.Touch(index);
+            Stamp(index);
             data[index] = object;
         }
 
         T& Get(int index) {
+            history.Touch(data, index);
+            stateHash.Touch(index);
+            Stamp(index);
             return static_cast<T&>(data[index]);
         }
 
+        // For reading only, nothing is saved for rollback
+        const T& Read(int index) const {
+            return data[index];
+        }
+
         T& operator [](unsigned int index) {
+            history.Touch(data, index);
+            stateHash.Touch(index);
+            Stamp(index);
             return data[index];
         }
-};
\ No newline at end of file
+
+        // 0 for an element that was never written
+        uint32_t GetChangeTick(int index) const {
+            return index < static_cast<int>(changeTicks.size()) ? changeTicks[index] : 0;
+        }
+
+        void SetChangeTick(uint32_t tick) override {
+            changeTick = tick;
+        }
+
+        void BeginFrame(int frame) override {
+            history.BeginFrame(frame, data.size());
+        }
+
+        void Rollback(int frame) override {
+            // What comes back counts as written now, whoever cached it has to look again
+            history.Rollback(frame, data, [this](size_t first, size_t count) {
+                stateHash.TouchRange(first, count);
+                StampRange(first, count);
+            });
+        }
+
+        void ClearHistory() override {
+            history.Clear();
+        }
+
+        uint64_t GetStateHash() override {
+            return stateHash.Get(data.size(), [this](size_t first, size_t count) {
+                return HashComponents(first, count);
+            });
+        }
+
+        uint64_t GetTypeHash() const override {
+            return HashSnapshotType(typeid(T).name(), 14695981039346656037ULL ^ sizeof(T));
+        }
+
+        /**
+         * Trivially copyable components are written as one block, the others one by one
+         * through their SaveComponent() (see Snapshot.h).
+        */
+        void Save(SnapshotWriter& writer) const override {
+            writer.Write(static_cast<uint32_t>(data.size()));
+            if constexpr (std::is_trivially_copyable<T>::value) {
+                writer.WriteBytes(data.data(), data.size() * sizeof(T));
+            } else {
+                for (const T& component: data) {
+                    SaveComponent(writer, component);
+                }
+            }
+        }
+
+        bool Load(SnapshotReader& reader) override {
+            uint32_t count;
+            if (!reader.Read(count)) {
+                return false;
+            }
+            if constexpr (std::is_trivially_copyable<T>::value) {
+                if (static_cast<uint64_t>(count) * sizeof(T) > reader.GetRemaining()) {
+                    return false;
+                }
+                loadedData.resize(count);
+                return reader.ReadBytes(loadedData.data(), count * sizeof(T));
+            } else {
+                // Every saved component takes at least a byte, a bad count fails before allocating
+                if (count > reader.GetRemaining()) {
+                    return false;
+                }
+                loadedData.assign(count, T());
+                for (T& component: loadedData) {
+                    if (!LoadComponent(reader, component)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+        }
+
+        void CommitLoad() override {
+            data.swap(loadedData);
+            std::vector<T>().swap(loadedData);
+            history.Clear();
+            stateHash.Clear();
+            changeTicks.assign(data.size(), changeTick);
+        }
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef ROLLBACKHISTORY_H
+#define ROLLBACKHISTORY_H
+
+#include <vector>
+#include <algorithm>
+
+// Frames the Registry can roll back, older ones are overwritten
+const int ROLLBACK_FRAMES = 240;
+// Elements per page, a page is copied whole the first time it is written in a frame
+const size_t ROLLBACK_PAGE_SIZE = 64;
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Rollback History ///////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Copy-on-write undo log of one array (a pool, the entity signatures). The
+// array is split in pages and the first write to a page during a frame
+// saves the page as it was before it, into a ring with one slot per frame.
+// Rolling back copies the saved pages back from the newest frame to the
+// oldest, so it costs what was written since, not the size of the array.
+// Whoever owns the array has to Touch() an element before writing to it,
+// elements added during the frame don't need it, they are cut off again.
+////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class RollbackHistory {
+    private:
+        struct Page {
+            size_t first;
+            std::vector<T> values;
+        };
+
+        struct Frame {
+            int frame = -1;
+            // Size of the array when the frame began
+            size_t size = 0;
+            // Pages are reused from one lap of the ring to the next, only the first pageCount are in use
+            size_t pageCount = 0;
+            std::vector<Page> pages;
+        };
+
+        std::vector<Frame> frames;
+        // Frame in which each page was last saved
+        std::vector<int> savedFrames;
+        int currentFrame = -1;
+        int firstFrame = -1;
+        size_t currentSize = 0;
+        bool recording = false;
+
+        void SavePage(const std::vector<T>& data, size_t page) {
+            if (page >= savedFrames.size()) {
+                savedFrames.resize(page + 1, -1);
+            }
+            savedFrames[page] = currentFrame;
+
+            Frame& record = frames[currentFrame % ROLLBACK_FRAMES];
+            if (record.pageCount == record.pages.size()) {
+                record.pages.emplace_back();
+            }
+            Page& saved = record.pages[record.pageCount++];
+            saved.first = page * ROLLBACK_PAGE_SIZE;
+            const size_t last = std::min(saved.first + ROLLBACK_PAGE_SIZE, currentSize);
+            saved.values.assign(data.begin() + saved.first, data.begin() + last);
+        }
+
+    public:
+        /**
+         * Starts recording the writes of `frame`, `size` being the size of the array now.
+         * Frames are expected one after the other, a gap starts the history over.
+        */
+        void BeginFrame(int frame, size_t size) {
+            if (frames.empty()) {
+                frames.resize(ROLLBACK_FRAMES);
+            }
+            if (firstFrame < 0 || frame != currentFrame + 1) {
+                firstFrame = frame;
+            }
+            currentFrame = frame;
+            currentSize = size;
+            recording = true;
+
+            Frame& record = frames[frame % ROLLBACK_FRAMES];
+            record.frame = frame;
+            record.size = size;
+            record.pageCount = 0;
+        }
+
+        // Has to be called before data[index] is written
+        void Touch(const std::vector<T>& data, size_t index) {
+            if (!recording || index >= currentSize) {
+                return;
+            }
+            const size_t page = index / ROLLBACK_PAGE_SIZE;
+            if (page < savedFrames.size() && savedFrames[page] == currentFrame) {
+                return;
+            }
+            SavePage(data, page);
+        }
+
+        void TouchRange(const std::vector<T>& data, size_t first, size_t count) {
+            if (!recording || count == 0) {
+                return;
+            }
+            const size_t last = std::min(first + count, currentSize);
+            for (size_t index = first; index < last; index += ROLLBACK_PAGE_SIZE - index % ROLLBACK_PAGE_SIZE) {
+                Touch(data, index);
+            }
+        }
+
+        /**
+         * Puts the array back the way it was when `frame` began and drops the frames after
+         * it. Frames from before the history started go back to where it started. Nothing
+         * is recorded until the next BeginFrame(). onRestore(first, count) is told about
+         * every range that was copied back.
+        */
+        template <typename TOnRestore>
+        void Rollback(int frame, std::vector<T>& data, TOnRestore onRestore) {
+            if (firstFrame < 0 || frame > currentFrame) {
+                return;
+            }
+            const int oldest = std::max(frame, std::max(firstFrame, currentFrame - ROLLBACK_FRAMES + 1));
+            const size_t size = frames[oldest % ROLLBACK_FRAMES].size;
+
+            for (int f = currentFrame; f >= oldest; f--) {
+                Frame& record = frames[f % ROLLBACK_FRAMES];
+                for (size_t i = 0; i < record.pageCount; i++) {
+                    const Page& saved = record.pages[i];
+                    if (data.size() < saved.first + saved.values.size()) {
+                        data.resize(saved.first + saved.values.size());
+                    }
+                    std::copy(saved.values.begin(), saved.values.end(), data.begin() + saved.first);
+                    onRestore(saved.first, saved.values.size());
+                }
+                record.frame = -1;
+                record.pageCount = 0;
+            }
+            data.resize(size);
+
+            std::fill(savedFrames.begin(), savedFrames.end(), -1);
+            currentFrame = frame - 1;
+            if (frame <= firstFrame) {
+                firstFrame = -1;
+            }
+            recording = false;
+        }
+
+        void Clear() {
+            frames.clear();
+            savedFrames.clear();
+            currentFrame = -1;
+            firstFrame = -1;
+            currentSize = 0;
+            recording = false;
+        }
+};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Snapshot streams ///////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Byte buffers the Registry writes its snapshots through. Trivially copyable
+// values go in as raw memory, so a snapshot only loads in the build (and on
+// the platform) that wrote it. Components that hold strings or pointers
+// provide their own pair of functions, found when their Pool is compiled:
+//   void SaveComponent(SnapshotWriter& writer, const MyComponent& component);
+//   bool LoadComponent(SnapshotReader& reader, MyComponent& component);
+////////////////////////////////////////////////////////////////////////////
+class SnapshotWriter {
+    private:
+        std::vector<char> buffer;
+
+    public:
+        const std::vector<char>& GetBuffer() const {
+            return buffer;
+        }
+
+        size_t GetSize() const {
+            return buffer.size();
+        }
+
+        void Clear() {
+            buffer.clear();
+        }
+
+        void WriteBytes(const void* data, size_t size) {
+            const char* bytes = static_cast<const char*>(data);
+            buffer.insert(buffer.end(), bytes, bytes + size);
+        }
+
+        template <typename T>
+        void Write(const T& value) {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written raw");
+            WriteBytes(&value, sizeof(T));
+        }
+
+        void WriteString(const std::string& value) {
+            Write(static_cast<uint32_t>(value.size()));
+            WriteBytes(value.data(), value.size());
+        }
+
+        // Overwrites a value written earlier, for sizes only known once what follows is written
+        template <typename T>
+        void Patch(size_t offset, const T& value) {
+            std::memcpy(buffer.data() + offset, &value, sizeof(T));
+        }
+};
+
+/**
+ * Reads what a SnapshotWriter wrote. Every read checks the bounds and returns false
+ * once the data runs out, a truncated file fails instead of reading garbage.
+*/
+class SnapshotReader {
+    private:
+        const char* cursor;
+        const char* end;
+
+    public:
+        SnapshotReader(const char* data, size_t size): cursor(data), end(data + size) {}
+
+        size_t GetRemaining() const {
+            return end - cursor;
+        }
+
+        bool ReadBytes(void* data, size_t size) {
+            if (size > GetRemaining()) {
+                cursor = end;
+                return false;
+            }
+            if (size == 0) {
+                return true;
+            }
+            std::memcpy(data, cursor, size);
+            cursor += size;
+            return true;
+        }
+
+        template <typename T>
+        bool Read(T& value) {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read raw");
+            return ReadBytes(&value, sizeof(T));
+        }
+
+        bool ReadString(std::string& value) {
+            uint32_t length;
+            if (!Read(length) || length > GetRemaining()) {
+                return false;
+            }
+            value.assign(cursor, length);
+            cursor += length;
+            return true;
+        }
+
+        // Splits off the next `size` bytes as their own reader
+        bool Take(size_t size, SnapshotReader& section) {
+            if (size > GetRemaining()) {
+                return false;
+            }
+            section = SnapshotReader(cursor, size);
+            cursor += size;
+            return true;
+        }
+};
+
+// FNV-1a, identifies the type stored in a pool so a snapshot never loads into the wrong one
+inline uint64_t HashSnapshotType(const char* name, uint64_t hash = 14695981039346656037ULL) {
+    for (; *name; name++) {
+        hash ^= static_cast<unsigned char>(*name);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Snapshot format ////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// [SnapshotFileHeader][signatures: uint32 each][entities awaiting spawn:
+// int32 ids][systems: (uint64 type hash, uint32 count, int32 ids)...]
+// [pools: (SnapshotPoolHeader, pool data)...]. Pool data is whatever the
+// pool's Save() wrote, and its size is in the pool header so a pool that
+// can't be loaded is skipped over.
+////////////////////////////////////////////////////////////////////////////
+struct SnapshotFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entityCount;
+    uint32_t signatureCount;
+    uint32_t spawnCount;
+    uint32_t systemCount;
+    uint32_t poolCount;
+};
+
+struct SnapshotPoolHeader {
+    int32_t componentId;
+    uint64_t typeHash;
+    uint64_t size;
+};
+
+const char SNAPSHOT_FILE_MAGIC[4] = {'S', 'N', 'A', 'P'};
+const uint32_t SNAPSHOT_FILE_VERSION = 3;
+
+#endif
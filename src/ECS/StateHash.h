@@ -0,0 +1,131 @@
+#ifndef STATEHASH_H
+#define STATEHASH_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+// Elements per hashed page
+const size_t STATE_HASH_PAGE_SIZE = 64;
+
+// FNV-1a over raw bytes, eight at a time
+inline uint64_t HashStateBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ULL) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash ^= word;
+        hash *= 1099511628211ULL;
+    }
+    for (; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Spreads the bits of a hash (splitmix64 finalizer), so sums of hashes don't cancel out
+inline uint64_t MixStateHash(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// State Hash /////////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Hash of an array kept up to date as it changes. The array is split in
+// pages, each with its own hash, and the hash of the array is their sum.
+// Writes only mark their page dirty, Get() rehashes the dirty pages and
+// patches the sum, so it costs what changed since the last call. Whoever
+// owns the array has to Touch() an element when writing to it, pages that
+// appear or change size when the array is resized are picked up on their
+// own.
+////////////////////////////////////////////////////////////////////////////
+class StateHash {
+    private:
+        std::vector<uint64_t> pageHashes;
+        std::vector<uint8_t> dirtyFlags;
+        std::vector<size_t> dirtyPages;
+        size_t hashedSize = 0;
+        uint64_t hash = 0;
+
+        void MarkPage(size_t page) {
+            if (page >= dirtyFlags.size()) {
+                dirtyFlags.resize(page + 1, 0);
+            }
+            if (!dirtyFlags[page]) {
+                dirtyFlags[page] = 1;
+                dirtyPages.push_back(page);
+            }
+        }
+
+    public:
+        void Touch(size_t index) {
+            const size_t page = index / STATE_HASH_PAGE_SIZE;
+            if (page < dirtyFlags.size() && dirtyFlags[page]) {
+                return;
+            }
+            MarkPage(page);
+        }
+
+        void TouchRange(size_t first, size_t count) {
+            if (count == 0) {
+                return;
+            }
+            for (size_t page = first / STATE_HASH_PAGE_SIZE; page <= (first + count - 1) / STATE_HASH_PAGE_SIZE; page++) {
+                MarkPage(page);
+            }
+        }
+
+        // Forgets every page, the next Get() hashes the whole array
+        void Clear() {
+            pageHashes.clear();
+            dirtyFlags.clear();
+            dirtyPages.clear();
+            hashedSize = 0;
+            hash = 0;
+        }
+
+        /**
+         * Hash of the array, `size` being its current size. hashPage(first, count) has to
+         * return the hash of the elements [first, first + count).
+        */
+        template <typename THashPage>
+        uint64_t Get(size_t size, THashPage hashPage) {
+            const size_t pageCount = (size + STATE_HASH_PAGE_SIZE - 1) / STATE_HASH_PAGE_SIZE;
+
+            if (size != hashedSize) {
+                // The page the old end was in changed size, the ones after it are new or gone
+                TouchRange(std::min(size, hashedSize), std::max(size, hashedSize) - std::min(size, hashedSize));
+                while (pageHashes.size() > pageCount) {
+                    hash -= pageHashes.back();
+                    pageHashes.pop_back();
+                }
+                pageHashes.resize(pageCount, 0);
+                hashedSize = size;
+            }
+
+            for (size_t page: dirtyPages) {
+                dirtyFlags[page] = 0;
+                if (page >= pageCount) {
+                    continue;
+                }
+                const size_t first = page * STATE_HASH_PAGE_SIZE;
+                const size_t count = std::min(STATE_HASH_PAGE_SIZE, size - first);
+                const uint64_t pageHash = MixStateHash(hashPage(first, count) + page);
+                hash += pageHash - pageHashes[page];
+                pageHashes[page] = pageHash;
+            }
+            dirtyPages.clear();
+            return hash;
+        }
+};
+
+#endif
@@ -0,0 +1,3 @@
+#include "EventBus.h"
+
+int IEventType::nextId = 0;
@@ -0,0 +1,229 @@
+#ifndef EVENTBUS_H
+#define EVENTBUS_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "../Logger/Logger.h"
+
+// When a subscriber gets its events. Immediate ones are called from inside Emit(),
+// the others when the game dispatches that phase of the frame.
+enum EventPhase {
+    EVENT_PHASE_IMMEDIATE,
+    // Start of Game::Update, for what happened since the last frame (input)
+    EVENT_PHASE_PRE_UPDATE,
+    // End of Game::Update, after every system ran (collisions)
+    EVENT_PHASE_POST_UPDATE,
+    EVENT_PHASE_COUNT
+};
+
+// Gives every event type its own index, like Component<T> does for components
+struct IEventType {
+    protected:
+        static int nextId;
+};
+
+template <typename TEvent>
+class EventType: public IEventType {
+    public:
+        static int GetId() {
+            static auto id = nextId++;
+            return id;
+        }
+};
+
+class IEventChannel {
+    public:
+        virtual ~IEventChannel() {}
+        virtual void Dispatch(EventPhase phase) = 0;
+        virtual void Unsubscribe(void* owner) = 0;
+        virtual void Clear() = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Event Channel //////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Subscribers and queued events of one event type. Subscribers are a flat
+// array of (owner, plain function) pairs, the function being a trampoline
+// that calls the owner's member function, so there is no std::function and
+// nothing on the heap per subscriber. Deferred events are copied into a
+// ring buffer per phase that only grows when it fills up, so once it has
+// seen a busy frame emitting costs a copy and never allocates.
+////////////////////////////////////////////////////////////////////////////
+template <typename TEvent>
+class EventChannel: public IEventChannel {
+    private:
+        struct Subscriber {
+            void* owner;
+            void (*callback)(void* owner, const TEvent& event);
+            EventPhase phase;
+        };
+
+        struct Ring {
+            std::vector<TEvent> events;
+            size_t head = 0;
+            size_t count = 0;
+            // Subscribers that read from this ring, nothing is queued without them
+            int subscriberCount = 0;
+
+            void Push(const TEvent& event) {
+                if (count == events.size()) {
+                    Grow();
+                }
+                events[(head + count) & (events.size() - 1)] = event;
+                count++;
+            }
+
+            // Capacity stays a power of two so wrapping is a mask
+            void Grow() {
+                std::vector<TEvent> grown(std::max<size_t>(events.size() * 2, 64));
+                for (size_t i = 0; i < count; i++) {
+                    grown[i] = events[(head + i) & (events.size() - 1)];
+                }
+                events.swap(grown);
+                head = 0;
+            }
+        };
+
+        std::vector<Subscriber> subscribers;
+        Ring rings[EVENT_PHASE_COUNT];
+
+        void Notify(EventPhase phase, const TEvent& event) {
+            for (size_t i = 0; i < subscribers.size(); i++) {
+                if (subscribers[i].phase == phase) {
+                    subscribers[i].callback(subscribers[i].owner, event);
+                }
+            }
+        }
+
+    public:
+        void Subscribe(void* owner, void (*callback)(void*, const TEvent&), EventPhase phase) {
+            subscribers.push_back({ owner, callback, phase });
+            rings[phase].subscriberCount++;
+        }
+
+        void Unsubscribe(void* owner) override {
+            for (const Subscriber& subscriber: subscribers) {
+                if (subscriber.owner == owner) {
+                    rings[subscriber.phase].subscriberCount--;
+                }
+            }
+            subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(), [owner](const Subscriber& subscriber) {
+                return subscriber.owner == owner;
+            }), subscribers.end());
+        }
+
+        void Emit(const TEvent& event) {
+            if (rings[EVENT_PHASE_IMMEDIATE].subscriberCount > 0) {
+                Notify(EVENT_PHASE_IMMEDIATE, event);
+            }
+            for (int phase = EVENT_PHASE_IMMEDIATE + 1; phase < EVENT_PHASE_COUNT; phase++) {
+                if (rings[phase].subscriberCount > 0) {
+                    rings[phase].Push(event);
+                }
+            }
+        }
+
+        /**
+         * Delivers what was queued for the phase. Events emitted by the subscribers while
+         * this runs wait for the next dispatch of the phase.
+        */
+        void Dispatch(EventPhase phase) override {
+            Ring& ring = rings[phase];
+            size_t pending = ring.count;
+            while (pending > 0) {
+                // Copied out, a subscriber emitting may grow the ring under us
+                const TEvent event = ring.events[ring.head];
+                ring.head = (ring.head + 1) & (ring.events.size() - 1);
+                ring.count--;
+                pending--;
+                Notify(phase, event);
+            }
+        }
+
+        void Clear() override {
+            for (Ring& ring: rings) {
+                ring.head = 0;
+                ring.count = 0;
+            }
+        }
+};
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Event Bus //////////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// One channel per event type, found by index. Subscribe a member function:
+//   eventBus->Subscribe<CollisionEvent, MySystem, &MySystem::OnCollision>(this);
+// and emit with:
+//   eventBus->Emit(CollisionEvent(a, b, normal, depth));
+////////////////////////////////////////////////////////////////////////////
+class EventBus {
+    private:
+        std::vector<std::unique_ptr<IEventChannel>> channels;
+
+        template <typename TEvent>
+        EventChannel<TEvent>& GetChannel() {
+            const int eventId = EventType<TEvent>::GetId();
+            if (eventId >= static_cast<int>(channels.size())) {
+                channels.resize(eventId + 1);
+            }
+            if (!channels[eventId]) {
+                channels[eventId] = std::make_unique<EventChannel<TEvent>>();
+            }
+            return *static_cast<EventChannel<TEvent>*>(channels[eventId].get());
+        }
+
+        template <typename TEvent, typename TOwner, void (TOwner::*Callback)(const TEvent&)>
+        static void Trampoline(void* owner, const TEvent& event) {
+            (static_cast<TOwner*>(owner)->*Callback)(event);
+        }
+
+    public:
+        EventBus() {
+            Logger::Success("EventBus constructor called!");
+        }
+
+        ~EventBus() {
+            Logger::Success("EventBus destructor called!");
+        }
+
+        template <typename TEvent, typename TOwner, void (TOwner::*Callback)(const TEvent&)>
+        void Subscribe(TOwner* owner, EventPhase phase = EVENT_PHASE_IMMEDIATE) {
+            GetChannel<TEvent>().Subscribe(owner, &Trampoline<TEvent, TOwner, Callback>, phase);
+        }
+
+        /**
+         * Removes every subscription of the owner, for any event type
+        */
+        void Unsubscribe(void* owner) {
+            for (auto& channel: channels) {
+                if (channel) {
+                    channel->Unsubscribe(owner);
+                }
+            }
+        }
+
+        template <typename TEvent>
+        void Emit(const TEvent& event) {
+            GetChannel<TEvent>().Emit(event);
+        }
+
+        void Dispatch(EventPhase phase) {
+            for (size_t i = 0; i < channels.size(); i++) {
+                if (channels[i]) {
+                    channels[i]->Dispatch(phase);
+                }
+            }
+        }
+
+        // Drops queued events, subscriptions stay
+        void Clear() {
+            for (auto& channel: channels) {
+                if (channel) {
+                    channel->Clear();
+                }
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef COLLISIONEVENT_H
+#define COLLISIONEVENT_H
+
+#include <glm/glm.hpp>
+#include "../ECS/ECS.h"
+
+/**
+ * Two colliders overlap. The normal points from a to b and depth is how far they
+ * have to move apart along it.
+*/
+struct CollisionEvent {
+    Entity a;
+    Entity b;
+    glm::vec2 normal;
+    float depth;
+
+    CollisionEvent(Entity a = Entity(-1), Entity b = Entity(-1), glm::vec2 normal = glm::vec2(0, 0), float depth = 0.0f)
+        : a(a), b(b), normal(normal), depth(depth) {}
+};
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef KEYPRESSEDEVENT_H
+#define KEYPRESSEDEVENT_H
+
+#include <SDL2/SDL.h>
+
+struct KeyPressedEvent {
+    SDL_Keycode symbol;
+
+    KeyPressedEvent(SDL_Keycode symbol = SDLK_UNKNOWN): symbol(symbol) {}
+};
+
+#endif
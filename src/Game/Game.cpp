@@ -1,19 +1,38 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include <SDL2/SDL_ttf.h>
 #include <glm/glm.hpp>
 
 #include <cstdlib>
 #include <iostream>
+#include <fstream>
 
 #include "Game.h"
 
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
+#include "../Components/BoxColliderComponent.h"
+#include "../Components/CameraComponent.h"
+#include "../Components/AnimationComponent.h"
+#include "../Components/AudioSourceComponent.h"
+#include "../Components/TextLabelComponent.h"
+#include "../Components/ScriptComponent.h"
 #include "../Systems/MovementSystem.h"
+#include "../Systems/HierarchySystem.h"
 #include "../Systems/RenderSystem.h"
+#include "../Systems/SpatialGridSystem.h"
+#include "../Systems/CollisionSystem.h"
+#include "../Systems/CameraSystem.h"
+#include "../Systems/AnimationSystem.h"
+#include "../Systems/AudioSystem.h"
+#include "../Systems/RenderTextSystem.h"
+#include "../Systems/ScriptSystem.h"
+#include "../Scene/SceneLoader.h"
+#include "../Events/KeyPressedEvent.h"
 
 
 #include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
 #include "../ECS/ECS.h"
 
 // Define screen dimensions
@@ -24,6 +43,16 @@ Game::Game() {
     isRunning = false;
     registry = std::make_unique<Registry>();
     assetStore = std::make_unique<AssetStore>();
+    spatialGrid = std::make_unique<SpatialGrid>();
+    tilemap = std::make_unique<Tilemap>();
+    animationLibrary = std::make_unique<AnimationLibrary>();
+    audioThread = std::make_unique<AudioThread>();
+    textRenderer = std::make_unique<TextRenderer>();
+    scriptEngine = std::make_unique<ScriptEngine>(registry.get());
+    eventBus = std::make_unique<EventBus>();
+    replay = std::make_unique<Replay>();
+    checksumSampleId = Profiler::GetSampleId("World checksum");
+    frameRecords.resize(ROLLBACK_FRAMES);
     Logger::Success("Game constructor called!");
 
 }
@@ -37,7 +66,13 @@ Game::~Game() {
 /**
  * Initializing SDL components
 */
-void Game::Initialize() {
+void Game::Initialize(const GameOptions& gameOptions) {
+    options = gameOptions;
+
+    // Headless runs don't need a display, the dummy driver gives them a window that's never shown
+    if (options.headless) {
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    }
 
     if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
         Logger::Err("Error initializing SDL. ");
@@ -58,7 +93,7 @@ void Game::Initialize() {
                                           SDL_WINDOWPOS_UNDEFINED,
                                           SDL_WINDOWPOS_UNDEFINED,
                                           SCREEN_WIDTH, SCREEN_HEIGHT,
-                                          SDL_WINDOW_SHOWN);
+                                          options.headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN);
 
 
 
@@ -78,15 +113,43 @@ void Game::Initialize() {
         return;
     }
 
-    renderer = SDL_CreateRenderer(window, 1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    // Headless runs still need a renderer to load the textures, nothing is drawn with it
+    Uint32 rendererFlags = SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC;
+    if (options.headless) {
+        rendererFlags = SDL_RENDERER_SOFTWARE;
+    } else if (options.uncapped) {
+        rendererFlags = SDL_RENDERER_ACCELERATED;
+    }
+    renderer = SDL_CreateRenderer(window, options.headless ? -1 : 1, rendererFlags);
     
     if (!renderer) {
         Logger::Err("Error creating SDL renderer.");
         return;
     }
 
-     // Seed the random number generator using srand()
-    srand(time(NULL)); // Use the current time as the seed
+    if (TTF_Init() != 0) {
+        Logger::Err("Error initializing SDL TTF.");
+        return;
+    }
+
+    // Audio is optional, the game runs silent if there is no audio device
+    if (!options.headless) {
+        audioThread->Start(AUDIO_MAX_VOICES);
+    }
+
+    // The camera draws into the whole window
+    camera.viewportWidth = SCREEN_WIDTH;
+    camera.viewportHeight = SCREEN_HEIGHT;
+
+    // The random number generators are seeded in Setup()
+    randomSeed = static_cast<uint32_t>(time(NULL));
+    if (!options.replayPath.empty() && replay->StartPlaying(options.replayPath)) {
+        randomSeed = replay->GetSeed();
+    } else if (!options.recordPath.empty()) {
+        replay->StartRecording(options.recordPath, randomSeed);
+    }
+    // Scripts have to run out of budget at the same point on every run of a replay
+    scriptEngine->SetCountedBudget(replay->GetMode() != REPLAY_OFF);
 }
 
 /**
@@ -96,62 +159,42 @@ void Game::Setup() {
 
     // Add Systems
     registry->AddSystem<MovementSystem>();
+    registry->AddSystem<HierarchySystem>();
     registry->AddSystem<RenderSystem>();
-
-    std::vector<std::string> pathKeysIds;
-    std::map<std::string, std::string> paths = {
-        {"bullet", "./assets/images/bullet.png"},
-        {"chopper-spritesheet", "./assets/images/chopper-spritesheet.png"},
-        {"chopper", "./assets/images/chopper.png"},
-        {"landing-base", "./assets/images/landing-base.png"},
-        {"radar", "./assets/images/radar.png"},
-        {"takeoff-base", "./assets/images/takeoff-base.png"},
-        {"tank-panther-down", "./assets/images/tank-panther-down.png"},
-        {"tank-panther-left", "./assets/images/tank-panther-left.png"},
-        {"tank-panther-right", "./assets/images/tank-panther-right.png"},
-        {"tank-panther-up", "./assets/images/tank-panther-up.png"},
-        {"tank-tiger-down", "./assets/images/tank-tiger-down.png"},
-        {"tank-tiger-left", "./assets/images/tank-tiger-left.png"},
-        {"tank-tiger-right", "./assets/images/tank-tiger-right.png"},
-        {"tank-tiger-up", "./assets/images/tank-tiger-up.png"},
-        {"tree", "./assets/images/tree.png"},
-        {"truck-ford-down", "./assets/images/truck-ford-down.png"},
-        {"truck-ford-killed", "./assets/images/truck-ford-killed.png"},
-        {"truck-ford-left", "./assets/images/truck-ford-left.png"},
-        {"truck-ford-right", "./assets/images/truck-ford-right.png"},
-        {"truck-ford-up", "./assets/images/truck-ford-up.png"}
-    };
-
-    // Add the sprite sources to the asset store
-    for (auto path: paths) {
-        assetStore->AddTexture(renderer, path.first, path.second);
-        pathKeysIds.emplace_back(path.first);
+    registry->AddSystem<SpatialGridSystem>();
+    registry->AddSystem<CollisionSystem>();
+    registry->AddSystem<CameraSystem>();
+    registry->AddSystem<AnimationSystem>();
+    registry->AddSystem<AudioSystem>();
+    registry->AddSystem<RenderTextSystem>();
+    registry->AddSystem<ScriptSystem>();
+
+    registry->GetSystem<CameraSystem>().SubscribeToEvents(eventBus);
+    registry->GetSystem<SpatialGridSystem>().SubscribeToRegistry(registry, spatialGrid);
+    registry->GetSystem<RenderSystem>().SubscribeToRegistry(registry);
+    registry->GetSystem<CollisionSystem>().SubscribeToRegistry(registry);
+    registry->GetSystem<AudioSystem>().SubscribeToRegistry(registry);
+
+    // Everything in the level comes from the scene file
+    Scene scene;
+    const bool sceneLoaded = SceneLoader::Load("./assets/scenes/jungle.lua", scriptEngine->GetState(), scene);
+    // Only now: building a scene that isn't cached runs its Lua, which seeds and draws on its own.
+    // The scripts loaded next must get the same numbers whether it ran or not
+    srand(randomSeed);
+    scriptEngine->SetRandomSeed(randomSeed);
+    if (sceneLoaded) {
+        SceneLoader::Instantiate(scene, renderer, assetStore, tilemap, animationLibrary, scriptEngine, registry);
+        for (const SceneMusic& track: scene.music) {
+            audioThread->SetMusicVolume(static_cast<int>(track.volume * MIX_MAX_VOLUME));
+            audioThread->PlayMusic(scene.GetString(track.file), -1, track.fadeMs);
+        }
     }
 
-    // Create initial entities
-    for (int i = 0; i < 20; i++) {
-        Entity tree = registry->SpawnEntity();
-
-        double randomxpos = rand() % 500;
-        double randomypos = rand() % 500;
-
-        double randoxscale = rand() % 4;
-        double randomyscale = rand() % 4;
-
-        double randomrotation = rand() % 360;
-
-        double randomxvel = rand() % 200 - 100;
-        double randomyvel = rand() % 200 - 100;
-
-        int randPathIndex = rand() % 20;
-
-        // Add initial components to entities
-        tree.AddComponent<TransformComponent>(glm::vec2(randomxpos, randomypos), glm::vec2(1, 1), randomrotation);
-        tree.AddComponent<RigidBodyComponent>(glm::vec2(randomxvel, randomyvel));
-
-        tree.AddComponent<SpriteComponent>(pathKeysIds[randPathIndex], 50, 50);
+    // The world is as big as the map, or the window if there is no map
+    worldBounds = tilemap->GetWorldBounds();
+    if (worldBounds.w == 0 || worldBounds.h == 0) {
+        worldBounds = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
     }
-
 }
 
 /**
@@ -161,57 +204,125 @@ void Game::Run() {
     Setup();
     isRunning = true;
 
+    const double startMs = Profiler::NowMs();
+    int frames = 0;
     while (isRunning) {
         ProcessInput();
         Update();
-        Render();
+        if (!options.headless) {
+            Render();
+        }
+        frames++;
+    }
+
+    if (replay->GetMode() == REPLAY_PLAY) {
+        const double elapsedMs = Profiler::NowMs() - startMs;
+        Logger::Success("Replay ran " + std::to_string(frames) + " frames in " + std::to_string(elapsedMs) + " ms (" + std::to_string(frames > 0 ? elapsedMs / frames : 0.0) + " ms per frame)");
+        if (replay->GetDesyncFrame() < 0) {
+            Logger::Success("Replay matched the recording on every frame");
+        }
     }
 }
 
+/**
+ * Reads the input from SDL, or from the replay while one plays. Closing the window
+ * still works during a replay.
+*/
 void Game::ProcessInput() {
+    const bool playing = replay->GetMode() == REPLAY_PLAY;
     SDL_Event sdlEvent;
     while (SDL_PollEvent(&sdlEvent)) {
+        if (playing && (sdlEvent.type == SDL_KEYDOWN || sdlEvent.type == SDL_MOUSEWHEEL)) {
+            continue;
+        }
+        HandleEvent(sdlEvent);
         if (sdlEvent.type == SDL_QUIT) {
+            break;
+        }
+    }
+
+    if (playing) {
+        int eventCount = 0;
+        const SDL_Event* events = replay->GetFrameEvents(eventCount);
+        for (int i = 0; i < eventCount; i++) {
+            HandleEvent(events[i]);
+        }
+    }
+}
+
+void Game::HandleEvent(const SDL_Event& sdlEvent) {
+    // What changes the game is recorded, device resets only concern this run
+    if (sdlEvent.type == SDL_QUIT || sdlEvent.type == SDL_MOUSEWHEEL || sdlEvent.type == SDL_KEYDOWN) {
+        replay->RecordEvent(sdlEvent);
+    }
+
+    if (sdlEvent.type == SDL_QUIT) {
+        isRunning = false;
+    } else if (sdlEvent.type == SDL_RENDER_TARGETS_RESET || sdlEvent.type == SDL_RENDER_DEVICE_RESET) {
+        // Cached render targets lost their contents
+        tilemap->Invalidate();
+    } else if (sdlEvent.type == SDL_MOUSEWHEEL && sdlEvent.wheel.y != 0) {
+        registry->GetSystem<CameraSystem>().Zoom(sdlEvent.wheel.y > 0 ? 1.1f : 0.9f);
+    } else if (sdlEvent.type == SDL_KEYDOWN) {
+        Logger::Log("A key was pressed");
+        eventBus->Emit(KeyPressedEvent(sdlEvent.key.keysym.sym));
+        switch (sdlEvent.key.keysym.sym) {
+            // Escape Key
+            case SDLK_ESCAPE: {
+                Logger::Log("The scape key was pressed");
                 isRunning = false;
                 break;
-        } else if (sdlEvent.type == SDL_KEYDOWN) {
-            Logger::Log("A key was pressed");
-            switch (sdlEvent.key.keysym.sym) {
-                // Escape Key
-                case SDLK_ESCAPE: {
-                    Logger::Log("The scape key was pressed");
-                    isRunning = false;
-                    break;
-                }
-                // case SDLK_LEFT: {
-                //     playerPosition.x -= playerVelocity.x * deltaTime;
-                //     break;
-                // }
-                // case SDLK_RIGHT: {
-                //     playerPosition.x += playerVelocity.x * deltaTime;
-                //     break;
-                // }
-                // case SDLK_UP: {
-                //     playerPosition.y -= playerVelocity.y * deltaTime;
-                //     break;
-                // }
-                // case SDLK_DOWN: {
-                //     playerPosition.y += playerVelocity.y * deltaTime;
-                //     break;
-                // }
             }
+            case SDLK_F5: {
+                registry->SaveSnapshot(SNAPSHOT_PATH);
+                break;
+            }
+            case SDLK_F9: {
+                LoadWorld(SNAPSHOT_PATH);
+                break;
+            }
+            case SDLK_BACKSPACE: {
+                Rewind(REWIND_FRAMES);
+                break;
+            }
+            case SDLK_F7: {
+                Resimulate(REWIND_FRAMES);
+                break;
+            }
+            // case SDLK_LEFT: {
+            //     playerPosition.x -= playerVelocity.x * deltaTime;
+            //     break;
+            // }
+            // case SDLK_RIGHT: {
+            //     playerPosition.x += playerVelocity.x * deltaTime;
+            //     break;
+            // }
+            // case SDLK_UP: {
+            //     playerPosition.y -= playerVelocity.y * deltaTime;
+            //     break;
+            // }
+            // case SDLK_DOWN: {
+            //     playerPosition.y += playerVelocity.y * deltaTime;
+            //     break;
+            // }
         }
     }
 }
 
 void Game::Update() {
+    // A replay is over once its last frame ran
+    if (replay->IsFinished()) {
+        isRunning = false;
+        return;
+    }
+
     // Make sure we wait enough between frames to keep a consistent FPS
     int32_t milisecondsSinceLastUpdate = SDL_GetTicks() - endTimeAtPreviousFrame;
     // Logger::Log("milisecondsSinceLastUpdate -> " + std::to_string(milisecondsSinceLastUpdate));
 
     // If it has been less than the ms assigned per frame (16 ms @ 60fps), wait a bit
     int timeToWait = MILLISECONDS_PER_FRAME - milisecondsSinceLastUpdate;
-    if (timeToWait > 0 && timeToWait <= MILLISECONDS_PER_FRAME) {
+    if (!options.uncapped && timeToWait > 0 && timeToWait <= MILLISECONDS_PER_FRAME) {
         // Logger::Log("Waiting miliseconds -> " + std::to_string(timeToWait));
         SDL_Delay(timeToWait);
     }
@@ -221,20 +332,131 @@ void Game::Update() {
     // Logger::Log(std::to_string(deltaTimeSec));
     endTimeAtPreviousFrame = SDL_GetTicks();
 
+    // Replays simulate the frames they recorded, however long they take now
+    if (replay->GetMode() == REPLAY_PLAY) {
+        deltaTimeSec = replay->GetFrameDeltaTime();
+    }
+
+    registry->BeginFrame(frame);
+    FrameRecord& record = frameRecords[frame % ROLLBACK_FRAMES];
+    record.deltaTime = deltaTimeSec;
+    record.animationClockMs = registry->GetSystem<AnimationSystem>().GetClockMs();
+    record.behaviorResumes = scriptEngine->GetResumeCount();
+    Simulate(deltaTimeSec);
+    frame++;
+
+    // Recordings keep the checksum of every frame and replays check theirs against it
+    if (replay->GetMode() != REPLAY_OFF) {
+        const double checksumStartMs = Profiler::NowMs();
+        const uint64_t checksum = registry->GetChecksum();
+        Profiler::Record(checksumSampleId, Profiler::NowMs() - checksumStartMs);
+        replay->RecordFrame(deltaTimeSec, checksum);
+        replay->EndFrame(checksum);
+    }
+
+    // Presentation, it follows the simulation but isn't part of it
+    registry->GetSystem<AudioSystem>().Update(deltaTimeSec, camera, assetStore, audioThread);
+    scriptEngine->CollectGarbage(SCRIPT_GC_BUDGET_MS);
+}
+
+/**
+ * One step of the game world. Everything it changes in the Registry can be rolled back,
+ * see Rewind and Resimulate.
+*/
+void Game::Simulate(double deltaTime) {
+    // Deliver the events queued since the last frame (input)
+    eventBus->Dispatch(EVENT_PHASE_PRE_UPDATE);
+
     // Update all the systems that have to be run every frame
-    registry->GetSystem<MovementSystem>().Update(deltaTimeSec);
+    // Scripts go first so what they change is picked up by the rest of the frame
+    registry->GetSystem<ScriptSystem>().Update(deltaTime, scriptEngine);
+    registry->GetSystem<MovementSystem>().Update(deltaTime, worldBounds);
+    // Children follow their parents before anything looks at where they are
+    registry->GetSystem<HierarchySystem>().Update(registry);
+    registry->GetSystem<CameraSystem>().Update(camera, worldBounds);
+    registry->GetSystem<AnimationSystem>().Update(deltaTime, animationLibrary);
+    // Has to run after anything that moves entities
+    registry->GetSystem<SpatialGridSystem>().Update(spatialGrid);
+    registry->GetSystem<CollisionSystem>().Update(eventBus);
+    if (!registry->GetSystem<CollisionSystem>().GetCollisions().empty()) {
+        scriptEngine->Signal("collision");
+    }
+    eventBus->Dispatch(EVENT_PHASE_POST_UPDATE);
 
-    
     // Update Registry ALWAYS DO AT THE END TO AVOID CONFUSION
     registry->Update();
 }
 
+/**
+ * Loads a snapshot of the Registry. The services that index the entities were built for
+ * the old ones, so they start over and fill up again from the loaded world.
+*/
+void Game::LoadWorld(const std::string& snapshotPath) {
+    if (!registry->LoadSnapshot(snapshotPath)) {
+        return;
+    }
+    spatialGrid->Clear();
+    registry->GetSystem<CollisionSystem>().Reset();
+    registry->GetSystem<AudioSystem>().Reset(audioThread);
+    scriptEngine->StopBehaviors();
+}
+
+/**
+ * Takes the world back up to `frames` frames, as far as the Registry history goes
+*/
+void Game::Rewind(int frames) {
+    const int oldest = registry->GetOldestRollbackFrame();
+    if (oldest < 0) {
+        return;
+    }
+    const int target = std::max(frame - frames, oldest);
+    if (registry->Rollback(target)) {
+        frame = target;
+        registry->GetSystem<AnimationSystem>().SetClockMs(frameRecords[target % ROLLBACK_FRAMES].animationClockMs);
+    }
+}
+
+/**
+ * Rewinds and simulates the same frames again with the same delta times. Everything in
+ * the Registry and the animation clock go back, what doesn't:
+ * - Lua globals and the behavior coroutines, with their scheduler clock. A behavior that
+ *   woke up in those frames doesn't wake up again, so the checksums are only compared
+ *   when none did.
+ * - The audio clock, audio isn't part of the simulation and doesn't run again.
+*/
+void Game::Resimulate(int frames) {
+    const int lastFrame = frame;
+    const uint64_t checksum = registry->GetChecksum();
+    const int resumeCount = scriptEngine->GetResumeCount();
+    const double startMs = Profiler::NowMs();
+    Rewind(frames);
+    const int firstFrame = frame;
+    const bool behaviorsRan = firstFrame < lastFrame && frameRecords[firstFrame % ROLLBACK_FRAMES].behaviorResumes != resumeCount;
+    while (frame < lastFrame) {
+        registry->BeginFrame(frame);
+        Simulate(frameRecords[frame % ROLLBACK_FRAMES].deltaTime);
+        frame++;
+    }
+    Logger::Log("Simulated frames " + std::to_string(firstFrame) + " to " + std::to_string(lastFrame - 1) + " again in " + std::to_string(Profiler::NowMs() - startMs) + " ms");
+    if (behaviorsRan) {
+        Logger::Log("Behaviors ran in those frames and weren't rewound, the result can't be compared");
+    } else if (registry->GetChecksum() != checksum) {
+        Logger::Err("The frames came out different the second time, the simulation is not deterministic");
+    }
+}
+
 void Game::Render() {
     // BG Color Mechanism :)
     RenderMovingColor();
 
+    // Render Background
+    tilemap->Render(renderer, assetStore, camera);
+
     // Render Game Objects  
-    registry->GetSystem<RenderSystem>().Update(renderer, assetStore);
+    registry->GetSystem<RenderSystem>().Update(renderer, assetStore, camera, spatialGrid);
+
+    // Render Text, on top of everything
+    registry->GetSystem<RenderTextSystem>().Update(renderer, assetStore, textRenderer, camera);
 
     // Render final  
     SDL_RenderPresent(renderer);
@@ -272,6 +494,19 @@ void Game::RenderMovingColor() {
  * Destroy SDL components
 */
 void Game::Destroy() {
+    replay->Stop();
+
+    // Textures have to go before the renderer that owns them,
+    // sounds once the audio thread can't be playing them anymore
+    registry->GetSystem<AudioSystem>().StopAll(audioThread);
+    audioThread->Stop();
+    tilemap->Clear();
+    textRenderer->Clear();
+    scriptEngine->Clear();
+    eventBus->Clear();
+    Profiler::Report();
+    assetStore->ClearAssests();
+    TTF_Quit();
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
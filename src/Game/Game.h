@@ -3,24 +3,76 @@
 
 # include "../ECS/ECS.h"
 # include "../AssetStore/AssetStore.h"
+# include "../Spatial/SpatialGrid.h"
+# include "../Tilemap/Tilemap.h"
+# include "../Camera/Camera.h"
+# include "../Animation/AnimationLibrary.h"
+# include "../Audio/AudioThread.h"
+# include "../Text/TextRenderer.h"
+# include "../Scripting/ScriptEngine.h"
+# include "../EventBus/EventBus.h"
+# include "../Replay/Replay.h"
 # include <SDL2/SDL.h>
 
 const int FPS = 120;
 const int MILLISECONDS_PER_FRAME = 1000 / FPS;
+// Quick save (F5) and quick load (F9) of the whole world
+const char SNAPSHOT_PATH[] = "./world.snapshot";
+// Backspace rewinds this many frames, F7 rewinds them and simulates them again
+const int REWIND_FRAMES = FPS;
+
+// Command line options, see Main.cpp
+struct GameOptions {
+    // Record the run to this file
+    std::string recordPath;
+    // Play this recording instead of reading the input
+    std::string replayPath;
+    // Hidden window, no rendering and no audio
+    bool headless = false;
+    // Run frames back to back instead of at FPS
+    bool uncapped = false;
+};
 
 class Game {
 
     private:
         bool isRunning;
+        GameOptions options;
+        // The current time, or the seed of the replay
+        uint32_t randomSeed = 0;
         int count = 0;
         bool increasing = false;
         int endTimeAtPreviousFrame = 0;
+        // Simulation frame, the Registry records each one for rollback
+        int frame = 0;
+        // What the last ROLLBACK_FRAMES frames started with outside of the Registry
+        struct FrameRecord {
+            // To simulate the frame again
+            double deltaTime = 0;
+            // Put back on rollback
+            double animationClockMs = 0;
+            // Behaviors aren't rolled back, the frames can only be compared if none ran
+            int behaviorResumes = 0;
+        };
+        std::vector<FrameRecord> frameRecords;
+        int checksumSampleId;
 
         SDL_Window* window;
         SDL_Renderer* renderer;
+        Camera camera;
+        // Area entities are allowed to move in, in world coordinates
+        SDL_Rect worldBounds;
 
         std::unique_ptr<Registry> registry;
         std::unique_ptr<AssetStore> assetStore;
+        std::unique_ptr<SpatialGrid> spatialGrid;
+        std::unique_ptr<Tilemap> tilemap;
+        std::unique_ptr<AnimationLibrary> animationLibrary;
+        std::unique_ptr<AudioThread> audioThread;
+        std::unique_ptr<TextRenderer> textRenderer;
+        std::unique_ptr<ScriptEngine> scriptEngine;
+        std::unique_ptr<EventBus> eventBus;
+        std::unique_ptr<Replay> replay;
 
 
     public:
@@ -32,11 +84,16 @@ class Game {
         Game();
         ~Game();
 
-        void Initialize();
+        void Initialize(const GameOptions& gameOptions = GameOptions());
         void Setup();
         void Run();
         void ProcessInput();
+        void HandleEvent(const SDL_Event& sdlEvent);
         void Update();
+        void Simulate(double deltaTime);
+        void LoadWorld(const std::string& snapshotPath);
+        void Rewind(int frames);
+        void Resimulate(int frames);
         void Render();
         void RenderMovingColor();
         void Destroy();
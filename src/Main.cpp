@@ -1,4 +1,7 @@
 #include "Game/Game.h"
+#include "Tilemap/Tilemap.h"
+#include "Logger/Logger.h"
+#include <string>
 // #include <SDL2/SDL.h>
 // #include <SDL2/SDL_image.h>
 // #include <SDL2/SDL_ttf.h>
@@ -9,10 +12,33 @@
 
 
 int main(int argc, char* argv[]) {
+
+    // ./gameengine --convert-map <map.csv> <map.tmap>
+    if (argc == 4 && std::string(argv[1]) == "--convert-map") {
+        return Tilemap::ConvertCsvToBinary(argv[2], argv[3]) ? 0 : 1;
+    }
 	
+    // ./gameengine [--record <file>] [--replay <file>] [--headless] [--uncapped]
+    GameOptions options;
+    for (int i = 1; i < argc; i++) {
+        const std::string option = argv[i];
+        if (option == "--record" && i + 1 < argc) {
+            options.recordPath = argv[++i];
+        } else if (option == "--replay" && i + 1 < argc) {
+            options.replayPath = argv[++i];
+        } else if (option == "--headless") {
+            options.headless = true;
+        } else if (option == "--uncapped") {
+            options.uncapped = true;
+        } else {
+            Logger::Err("Unknown option " + option);
+            return 1;
+        }
+    }
+
     Game game;
 
-    game.Initialize();
+    game.Initialize(options);
     game.Run();
     game.Destroy();
 
@@ -0,0 +1,49 @@
+#include <chrono>
+#include <cstdio>
+#include "Profiler.h"
+#include "../Logger/Logger.h"
+
+
+std::vector<ProfilerSample> Profiler::samples;
+
+double Profiler::NowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Returns the id of the sample with that name, creating it if needed
+*/
+int Profiler::GetSampleId(const std::string& name) {
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (samples[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    ProfilerSample sample;
+    sample.name = name;
+    samples.push_back(sample);
+    return static_cast<int>(samples.size() - 1);
+}
+
+void Profiler::Record(int sampleId, double milliseconds) {
+    ProfilerSample& sample = samples[sampleId];
+    sample.lastMs = milliseconds;
+    sample.totalMs += milliseconds;
+    sample.count++;
+    if (milliseconds > sample.maxMs) {
+        sample.maxMs = milliseconds;
+    }
+}
+
+void Profiler::Report() {
+    for (const ProfilerSample& sample: samples) {
+        if (sample.count == 0) {
+            continue;
+        }
+        char line[160];
+        std::snprintf(line, sizeof(line), "%s: %d samples, avg %.3f ms, max %.3f ms, total %.1f ms",
+            sample.name.c_str(), sample.count, sample.totalMs / sample.count, sample.maxMs, sample.totalMs);
+        Logger::Log(line);
+    }
+}
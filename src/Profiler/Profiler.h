@@ -0,0 +1,31 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+#include <vector>
+
+struct ProfilerSample {
+    std::string name;
+    double lastMs = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+    int count = 0;
+};
+
+/**
+ * Keeps timings of named parts of the frame. Look the id of a sample up once and record
+ * into it every frame, Report() logs the totals.
+*/
+class Profiler {
+
+    public:
+        static std::vector<ProfilerSample> samples;
+
+        static double NowMs();
+        static int GetSampleId(const std::string& name);
+        static void Record(int sampleId, double milliseconds);
+        static void Report();
+
+};
+
+#endif
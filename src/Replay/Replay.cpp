@@ -0,0 +1,167 @@
+#include "Replay.h"
+#include <fstream>
+#include <cstring>
+#include "../Logger/Logger.h"
+
+Replay::Replay() {
+    Logger::Success("Replay constructor called!");
+}
+
+Replay::~Replay() {
+    Logger::Success("Replay destructor called!");
+}
+
+bool Replay::StartRecording(const std::string& path, uint32_t randomSeed) {
+    mode = REPLAY_RECORD;
+    filePath = path;
+    seed = randomSeed;
+    frames.clear();
+    events.clear();
+    currentEvent = 0;
+    currentFrame = 0;
+    desyncFrame = -1;
+    Logger::Log("Recording replay to " + path);
+    return true;
+}
+
+bool Replay::StartPlaying(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        Logger::Err("Could not open replay " + path);
+        return false;
+    }
+    const size_t fileSize = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    ReplayFileHeader header;
+    if (fileSize < sizeof(header) ||
+        !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, REPLAY_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != REPLAY_FILE_VERSION) {
+        Logger::Err(path + " is not a replay of this version");
+        return false;
+    }
+    const uint64_t expectedSize = sizeof(header) + static_cast<uint64_t>(header.frameCount) * sizeof(ReplayFrame) + static_cast<uint64_t>(header.eventCount) * sizeof(SDL_Event);
+    if (expectedSize != fileSize) {
+        Logger::Err("Replay " + path + " is truncated");
+        return false;
+    }
+
+    frames.resize(header.frameCount);
+    events.resize(header.eventCount);
+    file.read(reinterpret_cast<char*>(frames.data()), frames.size() * sizeof(ReplayFrame));
+    file.read(reinterpret_cast<char*>(events.data()), events.size() * sizeof(SDL_Event));
+    for (const ReplayFrame& frame: frames) {
+        if (static_cast<uint64_t>(frame.firstEvent) + frame.eventCount > events.size()) {
+            Logger::Err("Replay " + path + " is corrupted");
+            frames.clear();
+            events.clear();
+            return false;
+        }
+    }
+
+    mode = REPLAY_PLAY;
+    filePath = path;
+    seed = header.seed;
+    currentEvent = 0;
+    currentFrame = 0;
+    desyncFrame = -1;
+    Logger::Log("Playing replay " + path + " (" + std::to_string(frames.size()) + " frames)");
+    return true;
+}
+
+bool Replay::Stop() {
+    const ReplayMode stopped = mode;
+    mode = REPLAY_OFF;
+    if (stopped != REPLAY_RECORD) {
+        return true;
+    }
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        Logger::Err("Could not create replay " + filePath);
+        return false;
+    }
+
+    ReplayFileHeader header;
+    std::memcpy(header.magic, REPLAY_FILE_MAGIC, sizeof(header.magic));
+    header.version = REPLAY_FILE_VERSION;
+    header.seed = seed;
+    header.frameCount = static_cast<uint32_t>(frames.size());
+    header.eventCount = static_cast<uint32_t>(events.size());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(frames.data()), frames.size() * sizeof(ReplayFrame));
+    file.write(reinterpret_cast<const char*>(events.data()), events.size() * sizeof(SDL_Event));
+
+    Logger::Success("Replay of " + std::to_string(frames.size()) + " frames written to " + filePath);
+    return true;
+}
+
+ReplayMode Replay::GetMode() const {
+    return mode;
+}
+
+uint32_t Replay::GetSeed() const {
+    return seed;
+}
+
+int Replay::GetFrameCount() const {
+    return static_cast<int>(frames.size());
+}
+
+//////// Recording ////////
+
+void Replay::RecordEvent(const SDL_Event& event) {
+    if (mode == REPLAY_RECORD) {
+        events.push_back(event);
+    }
+}
+
+void Replay::RecordFrame(double deltaTime, uint64_t checksum) {
+    if (mode != REPLAY_RECORD) {
+        return;
+    }
+    ReplayFrame frame;
+    frame.deltaTime = deltaTime;
+    frame.firstEvent = static_cast<uint32_t>(currentEvent);
+    frame.eventCount = static_cast<uint32_t>(events.size() - currentEvent);
+    frame.checksum = checksum;
+    frames.push_back(frame);
+    currentEvent = events.size();
+}
+
+//////// Playing ////////
+
+bool Replay::IsFinished() const {
+    return mode == REPLAY_PLAY && currentFrame >= frames.size();
+}
+
+const SDL_Event* Replay::GetFrameEvents(int& count) const {
+    if (mode != REPLAY_PLAY || currentFrame >= frames.size()) {
+        count = 0;
+        return nullptr;
+    }
+    const ReplayFrame& frame = frames[currentFrame];
+    count = static_cast<int>(frame.eventCount);
+    return events.data() + frame.firstEvent;
+}
+
+double Replay::GetFrameDeltaTime() const {
+    return mode == REPLAY_PLAY && currentFrame < frames.size() ? frames[currentFrame].deltaTime : 0.0;
+}
+
+void Replay::EndFrame(uint64_t checksum) {
+    if (mode != REPLAY_PLAY || currentFrame >= frames.size()) {
+        return;
+    }
+    // Only the first one is reported, every frame after it differs as well
+    if (desyncFrame < 0 && frames[currentFrame].checksum != checksum) {
+        desyncFrame = static_cast<int>(currentFrame);
+        Logger::Err("Replay desync at frame " + std::to_string(currentFrame) + ", the world is not the one that was recorded");
+    }
+    currentFrame++;
+}
+
+int Replay::GetDesyncFrame() const {
+    return desyncFrame;
+}
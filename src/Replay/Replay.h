@@ -0,0 +1,93 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <SDL2/SDL.h>
+
+enum ReplayMode {
+    REPLAY_OFF,
+    REPLAY_RECORD,
+    REPLAY_PLAY
+};
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Replay format //////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// [ReplayFileHeader][ReplayFrame...][SDL_Event...]
+// One ReplayFrame per game frame with its delta time, the range of the
+// events handled before it and the checksum of the world after it. The
+// events are raw SDL_Events, a replay is only meant to be played by a build
+// of the same SDL.
+////////////////////////////////////////////////////////////////////////////
+struct ReplayFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t seed;
+    uint32_t frameCount;
+    uint32_t eventCount;
+};
+
+struct ReplayFrame {
+    double deltaTime;
+    uint32_t firstEvent;
+    uint32_t eventCount;
+    uint64_t checksum;
+};
+
+const char REPLAY_FILE_MAGIC[4] = {'R', 'P', 'L', 'Y'};
+const uint32_t REPLAY_FILE_VERSION = 2;
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Replay /////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Records what makes a run different from the next one (the random seed,
+// the input events and the length of every frame) and plays it back, so a
+// run can be repeated exactly, to compare builds on the same workload.
+// Recordings are kept in memory and written when the recording stops.
+////////////////////////////////////////////////////////////////////////////
+class Replay {
+    private:
+        ReplayMode mode = REPLAY_OFF;
+        std::string filePath;
+        uint32_t seed = 0;
+
+        std::vector<ReplayFrame> frames;
+        std::vector<SDL_Event> events;
+
+        // Recording: first event of the frame being recorded. Playing: frame being played
+        size_t currentEvent = 0;
+        size_t currentFrame = 0;
+        // First frame whose checksum didn't match the recording, -1 while they all did
+        int desyncFrame = -1;
+
+    public:
+        Replay();
+        ~Replay();
+
+        bool StartRecording(const std::string& path, uint32_t randomSeed);
+        bool StartPlaying(const std::string& path);
+        // Writes the recording, if there is one
+        bool Stop();
+
+        ReplayMode GetMode() const;
+        uint32_t GetSeed() const;
+        int GetFrameCount() const;
+
+        //////// Recording ////////
+        void RecordEvent(const SDL_Event& event);
+        // Closes the frame with the events recorded since the last one
+        void RecordFrame(double deltaTime, uint64_t checksum);
+
+        //////// Playing ////////
+        bool IsFinished() const;
+        // Events to handle before the current frame
+        const SDL_Event* GetFrameEvents(int& count) const;
+        double GetFrameDeltaTime() const;
+        // Compares the world after the frame with the recording and moves to the next frame
+        void EndFrame(uint64_t checksum);
+        int GetDesyncFrame() const;
+};
+
+#endif
@@ -0,0 +1,556 @@
+#include "./SceneLoader.h"
+#include "../Logger/Logger.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../Components/BoxColliderComponent.h"
+#include "../Components/AnimationComponent.h"
+#include "../Components/CameraComponent.h"
+#include "../Components/AudioSourceComponent.h"
+#include "../Components/TextLabelComponent.h"
+#include "../Components/ScriptComponent.h"
+#include "../Components/ParentComponent.h"
+#include "../Tilemap/Tilemap.h"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <type_traits>
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Scene ////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+uint32_t Scene::AddString(const std::string& value) {
+    auto existing = stringIds.find(value);
+    if (existing != stringIds.end()) {
+        return existing->second;
+    }
+    const uint32_t index = static_cast<uint32_t>(strings.size());
+    strings.push_back(value);
+    stringIds.insert(std::make_pair(value, index));
+    return index;
+}
+
+const std::string& Scene::GetString(uint32_t index) const {
+    static const std::string empty;
+    return index < strings.size() ? strings[index] : empty;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Helpers //////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+// 64-bit FNV-1a
+static uint64_t HashSource(const std::string& source) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c: source) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+template <typename T>
+static void WriteArray(std::ofstream& file, const std::vector<T>& records) {
+    static_assert(std::is_trivially_copyable<T>::value, "Scene records are written as raw memory");
+    const uint32_t count = static_cast<uint32_t>(records.size());
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(records.data()), count * sizeof(T));
+}
+
+// Reads from a file loaded in memory, failing instead of going past its end
+struct SceneReader {
+    const char* cursor;
+    const char* end;
+
+    bool Read(void* destination, size_t size) {
+        if (static_cast<size_t>(end - cursor) < size) {
+            return false;
+        }
+        std::memcpy(destination, cursor, size);
+        cursor += size;
+        return true;
+    }
+
+    template <typename T>
+    bool ReadArray(std::vector<T>& records) {
+        uint32_t count = 0;
+        if (!Read(&count, sizeof(count)) || static_cast<size_t>(end - cursor) / sizeof(T) < count) {
+            return false;
+        }
+        records.resize(count);
+        return Read(records.data(), count * sizeof(T));
+    }
+};
+
+static glm::vec2 GetVec2(const sol::table& table, const char* key, glm::vec2 fallback) {
+    sol::optional<sol::table> value = table[key];
+    if (!value) {
+        return fallback;
+    }
+    return glm::vec2(value->get_or(1, fallback.x), value->get_or(2, fallback.y));
+}
+
+/**
+ * Turns records into components and adds them to the spawned entities in a single batch
+*/
+template <typename TComponent, typename TRecord, typename TMake>
+static void AddComponents(std::unique_ptr<Registry>& registry, const std::vector<Entity>& spawned, const std::vector<TRecord>& records, TMake make) {
+    if (records.empty()) {
+        return;
+    }
+    std::vector<Entity> entities;
+    std::vector<TComponent> components;
+    entities.reserve(records.size());
+    components.reserve(records.size());
+
+    for (const TRecord& record: records) {
+        if (record.entity < spawned.size()) {
+            entities.push_back(spawned[record.entity]);
+            components.push_back(make(record));
+        }
+    }
+    registry->AddComponentsToEntities<TComponent>(entities, components);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Scene Loader /////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * assets/scenes/jungle.lua -> assets/scenes/jungle.scene
+*/
+std::string SceneLoader::GetCachePath(const std::string& scenePath) {
+    const size_t extension = scenePath.find_last_of('.');
+    const size_t directory = scenePath.find_last_of('/');
+    if (extension == std::string::npos || (directory != std::string::npos && extension < directory)) {
+        return scenePath + ".scene";
+    }
+    return scenePath.substr(0, extension) + ".scene";
+}
+
+/**
+ * Fills `scene` from the cache if it matches the Lua source, otherwise runs the Lua and
+ * writes a new cache for the next time.
+*/
+bool SceneLoader::Load(const std::string& scenePath, sol::state& lua, Scene& scene) {
+    std::ifstream file(scenePath, std::ios::binary);
+    if (!file.is_open()) {
+        Logger::Err("Could not open scene " + scenePath);
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string source = buffer.str();
+
+    const uint64_t sourceHash = HashSource(source);
+    const std::string cachePath = GetCachePath(scenePath);
+
+    if (ReadCache(cachePath, sourceHash, scene)) {
+        Logger::Success("Scene " + scenePath + " loaded from " + cachePath);
+        return true;
+    }
+
+    scene = Scene();
+    if (!BuildFromLua(source, scenePath, lua, scene)) {
+        return false;
+    }
+    scene.stringIds.clear();
+
+    if (WriteCache(cachePath, sourceHash, scene)) {
+        Logger::Success("Scene " + scenePath + " loaded and cached in " + cachePath);
+    }
+    return true;
+}
+
+bool SceneLoader::BuildFromLua(const std::string& source, const std::string& scenePath, sol::state& lua, Scene& scene) {
+    sol::environment environment(lua, sol::create, lua.globals());
+
+    // map_size(file): columns and rows of a CSV tilemap, so the scene can fit itself to the map
+    environment.set_function("map_size", [](const std::string& mapPath) {
+        std::vector<int> tiles;
+        int width = 0;
+        int height = 0;
+        if (!Tilemap::ParseCsv(mapPath, tiles, width, height)) {
+            width = 0;
+            height = 0;
+        }
+        return std::make_tuple(width, height);
+    });
+
+    sol::protected_function_result result = lua.safe_script(source, environment, sol::script_pass_on_error, scenePath);
+    if (!result.valid()) {
+        sol::error error = result;
+        Logger::Err("Error running scene " + scenePath + ": " + error.what());
+        return false;
+    }
+
+    sol::optional<sol::table> root = result;
+    if (!root) {
+        Logger::Err("Scene " + scenePath + " has to return a table");
+        return false;
+    }
+    const sol::table& sceneTable = *root;
+
+    // Assets. Textures, sounds and scripts are id = path tables, fonts also need a size
+    const std::pair<const char*, SceneAssetType> assetTables[] = {
+        {"textures", SCENE_ASSET_TEXTURE},
+        {"sounds", SCENE_ASSET_SOUND},
+        {"scripts", SCENE_ASSET_SCRIPT}
+    };
+    for (const auto& assetTable: assetTables) {
+        sol::optional<sol::table> assets = sceneTable[assetTable.first];
+        if (!assets) {
+            continue;
+        }
+        for (const auto& asset: *assets) {
+            if (asset.first.get_type() != sol::type::string || asset.second.get_type() != sol::type::string) {
+                continue;
+            }
+            scene.assets.push_back({
+                assetTable.second,
+                scene.AddString(asset.first.as<std::string>()),
+                scene.AddString(asset.second.as<std::string>()),
+                0
+            });
+        }
+    }
+
+    sol::optional<sol::table> fonts = sceneTable["fonts"];
+    if (fonts) {
+        for (size_t i = 1; i <= fonts->size(); i++) {
+            sol::table font = (*fonts)[i];
+            scene.assets.push_back({
+                SCENE_ASSET_FONT,
+                scene.AddString(font.get_or<std::string>("id", "")),
+                scene.AddString(font.get_or<std::string>("file", "")),
+                font.get_or("size", 12)
+            });
+        }
+    }
+
+    sol::optional<sol::table> tilemap = sceneTable["tilemap"];
+    if (tilemap) {
+        scene.tilemaps.push_back({
+            scene.AddString(tilemap->get_or<std::string>("file", "")),
+            scene.AddString(tilemap->get_or<std::string>("binary_file", "")),
+            scene.AddString(tilemap->get_or<std::string>("tileset", "")),
+            tilemap->get_or("tile_size", 32),
+            tilemap->get_or("tileset_columns", 1)
+        });
+    }
+
+    sol::optional<sol::table> music = sceneTable["music"];
+    if (music) {
+        scene.music.push_back({
+            scene.AddString(music->get_or<std::string>("file", "")),
+            music->get_or("volume", 1.0f),
+            music->get_or("fade_ms", 0)
+        });
+    }
+
+    sol::optional<sol::table> animations = sceneTable["animations"];
+    if (animations) {
+        for (size_t i = 1; i <= animations->size(); i++) {
+            sol::table clip = (*animations)[i];
+            scene.clips.push_back({
+                scene.AddString(clip.get_or<std::string>("name", "")),
+                clip.get_or("frame_width", 0),
+                clip.get_or("frame_height", 0),
+                clip.get_or("column", 0),
+                clip.get_or("row", 0),
+                clip.get_or("frames", 1),
+                clip.get_or("fps", 10),
+                clip.get_or("loop", true) ? 1u : 0u
+            });
+        }
+    }
+
+    // Entities, each one is a table of components
+    sol::optional<sol::table> entities = sceneTable["entities"];
+    if (!entities) {
+        return true;
+    }
+
+    scene.entityCount = static_cast<uint32_t>(entities->size());
+    for (uint32_t entity = 0; entity < scene.entityCount; entity++) {
+        sol::table components = (*entities)[entity + 1];
+
+        sol::optional<sol::table> transform = components["transform"];
+        if (transform) {
+            const glm::vec2 position = GetVec2(*transform, "position", glm::vec2(0, 0));
+            const glm::vec2 scale = GetVec2(*transform, "scale", glm::vec2(1, 1));
+            scene.transforms.push_back({ entity, position.x, position.y, scale.x, scale.y, transform->get_or("rotation", 0.0f) });
+        }
+
+        sol::optional<sol::table> rigidBody = components["rigidbody"];
+        if (rigidBody) {
+            const glm::vec2 velocity = GetVec2(*rigidBody, "velocity", glm::vec2(0, 0));
+            scene.rigidBodies.push_back({ entity, velocity.x, velocity.y });
+        }
+
+        sol::optional<sol::table> sprite = components["sprite"];
+        if (sprite) {
+            scene.sprites.push_back({
+                entity,
+                scene.AddString(sprite->get_or<std::string>("texture", "")),
+                sprite->get_or("width", 0),
+                sprite->get_or("height", 0),
+                sprite->get_or("src_x", 0),
+                sprite->get_or("src_y", 0)
+            });
+        }
+
+        sol::optional<sol::table> boxCollider = components["box_collider"];
+        if (boxCollider) {
+            const glm::vec2 offset = GetVec2(*boxCollider, "offset", glm::vec2(0, 0));
+            scene.boxColliders.push_back({ entity, boxCollider->get_or("width", 0), boxCollider->get_or("height", 0), offset.x, offset.y });
+        }
+
+        sol::optional<std::string> animation = components["animation"];
+        if (animation) {
+            scene.animations.push_back({ entity, scene.AddString(*animation) });
+        }
+
+        sol::optional<sol::table> camera = components["camera"];
+        if (camera) {
+            scene.cameras.push_back({ entity, camera->get_or("zoom", 1.0f), camera->get_or("min_zoom", 0.25f), camera->get_or("max_zoom", 4.0f) });
+        }
+
+        sol::optional<sol::table> audioSource = components["audio_source"];
+        if (audioSource) {
+            scene.audioSources.push_back({
+                entity,
+                scene.AddString(audioSource->get_or<std::string>("sound", "")),
+                audioSource->get_or("volume", 1.0f),
+                audioSource->get_or("range", 500.0f),
+                audioSource->get_or("priority", 0),
+                audioSource->get_or("loop", false) ? 1u : 0u
+            });
+        }
+
+        sol::optional<sol::table> textLabel = components["text_label"];
+        if (textLabel) {
+            SceneTextLabel label;
+            label.entity = entity;
+            label.text = scene.AddString(textLabel->get_or<std::string>("text", ""));
+            label.fontId = scene.AddString(textLabel->get_or<std::string>("font", ""));
+            sol::optional<sol::table> color = (*textLabel)["color"];
+            for (int channel = 0; channel < 4; channel++) {
+                label.color[channel] = static_cast<uint8_t>(color ? color->get_or(channel + 1, 255) : 255);
+            }
+            label.isFixed = textLabel->get_or("fixed", true) ? 1u : 0u;
+            scene.textLabels.push_back(label);
+        }
+
+        sol::optional<std::string> script = components["script"];
+        if (script) {
+            scene.scripts.push_back({ entity, scene.AddString(*script) });
+        }
+
+        // The parent is the position of another entity in the list, from 1 like Lua
+        sol::optional<sol::table> parent = components["parent"];
+        if (parent) {
+            const uint32_t parentIndex = parent->get_or("entity", 0u);
+            if (parentIndex < 1 || parentIndex > scene.entityCount || parentIndex == entity + 1) {
+                Logger::Err("Entity " + std::to_string(entity + 1) + " of " + scenePath + " has no valid parent, ignoring it");
+            } else {
+                const glm::vec2 offset = GetVec2(*parent, "offset", glm::vec2(0, 0));
+                const glm::vec2 scale = GetVec2(*parent, "scale", glm::vec2(1, 1));
+                scene.parents.push_back({ entity, parentIndex - 1, offset.x, offset.y, scale.x, scale.y, parent->get_or("rotation", 0.0f) });
+            }
+        }
+    }
+
+    return true;
+}
+
+bool SceneLoader::ReadCache(const std::string& cachePath, uint64_t sourceHash, Scene& scene) {
+    std::ifstream file(cachePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<char> contents(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(contents.data(), contents.size())) {
+        return false;
+    }
+
+    SceneReader reader = { contents.data(), contents.data() + contents.size() };
+    SceneFileHeader header;
+    if (!reader.Read(&header, sizeof(header)) ||
+        std::memcmp(header.magic, SCENE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SCENE_FILE_VERSION ||
+        header.sourceHash != sourceHash) {
+        return false;
+    }
+
+    Scene cached;
+    cached.entityCount = header.entityCount;
+    cached.strings.resize(header.stringCount);
+    for (std::string& value: cached.strings) {
+        uint32_t length = 0;
+        if (!reader.Read(&length, sizeof(length)) || static_cast<size_t>(reader.end - reader.cursor) < length) {
+            return false;
+        }
+        value.assign(reader.cursor, length);
+        reader.cursor += length;
+    }
+
+    const bool complete =
+        reader.ReadArray(cached.assets) &&
+        reader.ReadArray(cached.clips) &&
+        reader.ReadArray(cached.tilemaps) &&
+        reader.ReadArray(cached.music) &&
+        reader.ReadArray(cached.transforms) &&
+        reader.ReadArray(cached.rigidBodies) &&
+        reader.ReadArray(cached.sprites) &&
+        reader.ReadArray(cached.boxColliders) &&
+        reader.ReadArray(cached.animations) &&
+        reader.ReadArray(cached.cameras) &&
+        reader.ReadArray(cached.audioSources) &&
+        reader.ReadArray(cached.textLabels) &&
+        reader.ReadArray(cached.scripts) &&
+        reader.ReadArray(cached.parents);
+    if (!complete) {
+        Logger::Err("Scene cache " + cachePath + " is truncated, rebuilding it");
+        return false;
+    }
+    // Entities are checked when they are spawned, parents index into them right away
+    for (const SceneParent& record: cached.parents) {
+        if (record.parent >= cached.entityCount) {
+            Logger::Err("Scene cache " + cachePath + " has a parent out of range, rebuilding it");
+            return false;
+        }
+    }
+
+    scene = std::move(cached);
+    return true;
+}
+
+bool SceneLoader::WriteCache(const std::string& cachePath, uint64_t sourceHash, const Scene& scene) {
+    std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        Logger::Err("Could not create scene cache " + cachePath);
+        return false;
+    }
+
+    SceneFileHeader header;
+    std::memcpy(header.magic, SCENE_FILE_MAGIC, sizeof(header.magic));
+    header.version = SCENE_FILE_VERSION;
+    header.sourceHash = sourceHash;
+    header.entityCount = scene.entityCount;
+    header.stringCount = static_cast<uint32_t>(scene.strings.size());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const std::string& value: scene.strings) {
+        const uint32_t length = static_cast<uint32_t>(value.size());
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(value.data(), length);
+    }
+
+    WriteArray(file, scene.assets);
+    WriteArray(file, scene.clips);
+    WriteArray(file, scene.tilemaps);
+    WriteArray(file, scene.music);
+    WriteArray(file, scene.transforms);
+    WriteArray(file, scene.rigidBodies);
+    WriteArray(file, scene.sprites);
+    WriteArray(file, scene.boxColliders);
+    WriteArray(file, scene.animations);
+    WriteArray(file, scene.cameras);
+    WriteArray(file, scene.audioSources);
+    WriteArray(file, scene.textLabels);
+    WriteArray(file, scene.scripts);
+    WriteArray(file, scene.parents);
+
+    if (!file.good()) {
+        Logger::Err("Could not write scene cache " + cachePath);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Loads the scene's assets and spawns its entities. Entities are spawned together and
+ * every component type is added to all of its entities in one batch.
+*/
+void SceneLoader::Instantiate(
+    const Scene& scene,
+    SDL_Renderer* renderer,
+    std::unique_ptr<AssetStore>& assetStore,
+    std::unique_ptr<Tilemap>& tilemap,
+    std::unique_ptr<AnimationLibrary>& animationLibrary,
+    std::unique_ptr<ScriptEngine>& scriptEngine,
+    std::unique_ptr<Registry>& registry
+) {
+    for (const SceneAsset& asset: scene.assets) {
+        const std::string& assetId = scene.GetString(asset.id);
+        const std::string& path = scene.GetString(asset.path);
+        switch (asset.type) {
+            case SCENE_ASSET_TEXTURE: assetStore->AddTexture(renderer, assetId, path); break;
+            case SCENE_ASSET_SOUND: assetStore->AddSound(assetId, path); break;
+            case SCENE_ASSET_FONT: assetStore->AddFont(assetId, path, asset.size); break;
+            case SCENE_ASSET_SCRIPT: scriptEngine->LoadScript(assetId, path); break;
+        }
+    }
+
+    for (const SceneTilemap& map: scene.tilemaps) {
+        const std::string& binaryPath = scene.GetString(map.binaryFile);
+        const std::string& tileset = scene.GetString(map.tileset);
+        if (binaryPath.empty() || !std::ifstream(binaryPath).good() || !tilemap->LoadBinary(binaryPath, tileset, map.tileSize, map.tilesetColumns)) {
+            tilemap->Load(scene.GetString(map.file), tileset, map.tileSize, map.tilesetColumns);
+        }
+    }
+
+    for (const SceneClip& clip: scene.clips) {
+        animationLibrary->AddClip(
+            scene.GetString(clip.name),
+            clip.frameWidth,
+            clip.frameHeight,
+            clip.firstColumn,
+            clip.row,
+            clip.frameCount,
+            clip.framesPerSecond,
+            clip.loop != 0
+        );
+    }
+
+    std::vector<Entity> spawned;
+    registry->SpawnEntities(static_cast<int>(scene.entityCount), spawned);
+
+    AddComponents<TransformComponent>(registry, spawned, scene.transforms, [](const SceneTransform& record) {
+        return TransformComponent(glm::vec2(record.x, record.y), glm::vec2(record.scaleX, record.scaleY), record.rotation);
+    });
+    AddComponents<RigidBodyComponent>(registry, spawned, scene.rigidBodies, [](const SceneRigidBody& record) {
+        return RigidBodyComponent(glm::vec2(record.velocityX, record.velocityY));
+    });
+    AddComponents<SpriteComponent>(registry, spawned, scene.sprites, [&scene](const SceneSprite& record) {
+        return SpriteComponent(scene.GetString(record.assetId), record.width, record.height, record.srcX, record.srcY);
+    });
+    AddComponents<BoxColliderComponent>(registry, spawned, scene.boxColliders, [](const SceneBoxCollider& record) {
+        return BoxColliderComponent(record.width, record.height, glm::vec2(record.offsetX, record.offsetY));
+    });
+    AddComponents<AnimationComponent>(registry, spawned, scene.animations, [&scene, &animationLibrary](const SceneAnimation& record) {
+        return AnimationComponent(animationLibrary->GetClipId(scene.GetString(record.clip)));
+    });
+    AddComponents<CameraComponent>(registry, spawned, scene.cameras, [](const SceneCamera& record) {
+        return CameraComponent(record.zoom, record.minZoom, record.maxZoom);
+    });
+    AddComponents<AudioSourceComponent>(registry, spawned, scene.audioSources, [&scene](const SceneAudioSource& record) {
+        return AudioSourceComponent(scene.GetString(record.soundId), record.volume, record.range, record.priority, record.loop != 0);
+    });
+    AddComponents<TextLabelComponent>(registry, spawned, scene.textLabels, [&scene](const SceneTextLabel& record) {
+        SDL_Color color = { record.color[0], record.color[1], record.color[2], record.color[3] };
+        return TextLabelComponent(scene.GetString(record.text), scene.GetString(record.fontId), color, record.isFixed != 0);
+    });
+    AddComponents<ScriptComponent>(registry, spawned, scene.scripts, [&scene](const SceneScript& record) {
+        return ScriptComponent(scene.GetString(record.scriptId));
+    });
+    AddComponents<ParentComponent>(registry, spawned, scene.parents, [&spawned](const SceneParent& record) {
+        const int parentId = record.parent < spawned.size() ? spawned[record.parent].GetId() : -1;
+        return ParentComponent(parentId, glm::vec2(record.offsetX, record.offsetY), glm::vec2(record.scaleX, record.scaleY), record.rotation);
+    });
+
+    Logger::Success("Scene instantiated with " + std::to_string(spawned.size()) + " entities");
+}
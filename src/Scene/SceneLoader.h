@@ -0,0 +1,219 @@
+#ifndef SCENELOADER_H
+#define SCENELOADER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include <SDL2/SDL.h>
+#include "../ECS/ECS.h"
+#include "../AssetStore/AssetStore.h"
+#include "../Tilemap/Tilemap.h"
+#include "../Animation/AnimationLibrary.h"
+#include "../Scripting/ScriptEngine.h"
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Scene records //////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// A scene flattened into plain arrays, one per kind of record. Strings live
+// in a single table and records point into it by index, and entity records
+// carry the index of the entity in the scene. Every record is trivially
+// copyable so each array is written to and read from disk as one block.
+////////////////////////////////////////////////////////////////////////////
+enum SceneAssetType: uint32_t {
+    SCENE_ASSET_TEXTURE,
+    SCENE_ASSET_SOUND,
+    SCENE_ASSET_FONT,
+    SCENE_ASSET_SCRIPT
+};
+
+struct SceneAsset {
+    uint32_t type;
+    uint32_t id;
+    uint32_t path;
+    // Font size, unused for the rest
+    int32_t size;
+};
+
+struct SceneClip {
+    uint32_t name;
+    int32_t frameWidth;
+    int32_t frameHeight;
+    int32_t firstColumn;
+    int32_t row;
+    int32_t frameCount;
+    int32_t framesPerSecond;
+    uint32_t loop;
+};
+
+struct SceneTilemap {
+    uint32_t file;
+    // Optional memory mapped version of the map, used instead of `file` when it exists
+    uint32_t binaryFile;
+    uint32_t tileset;
+    int32_t tileSize;
+    int32_t tilesetColumns;
+};
+
+struct SceneMusic {
+    uint32_t file;
+    float volume;
+    int32_t fadeMs;
+};
+
+struct SceneTransform {
+    uint32_t entity;
+    float x;
+    float y;
+    float scaleX;
+    float scaleY;
+    float rotation;
+};
+
+struct SceneRigidBody {
+    uint32_t entity;
+    float velocityX;
+    float velocityY;
+};
+
+struct SceneSprite {
+    uint32_t entity;
+    uint32_t assetId;
+    int32_t width;
+    int32_t height;
+    int32_t srcX;
+    int32_t srcY;
+};
+
+struct SceneBoxCollider {
+    uint32_t entity;
+    int32_t width;
+    int32_t height;
+    float offsetX;
+    float offsetY;
+};
+
+struct SceneAnimation {
+    uint32_t entity;
+    uint32_t clip;
+};
+
+struct SceneCamera {
+    uint32_t entity;
+    float zoom;
+    float minZoom;
+    float maxZoom;
+};
+
+struct SceneAudioSource {
+    uint32_t entity;
+    uint32_t soundId;
+    float volume;
+    float range;
+    int32_t priority;
+    uint32_t loop;
+};
+
+struct SceneTextLabel {
+    uint32_t entity;
+    uint32_t text;
+    uint32_t fontId;
+    uint8_t color[4];
+    uint32_t isFixed;
+};
+
+struct SceneScript {
+    uint32_t entity;
+    uint32_t scriptId;
+};
+
+struct SceneParent {
+    uint32_t entity;
+    // Index of the parent in the scene
+    uint32_t parent;
+    float offsetX;
+    float offsetY;
+    float scaleX;
+    float scaleY;
+    float rotation;
+};
+
+struct Scene {
+    uint32_t entityCount = 0;
+    std::vector<std::string> strings;
+
+    std::vector<SceneAsset> assets;
+    std::vector<SceneClip> clips;
+    // Empty or a single map
+    std::vector<SceneTilemap> tilemaps;
+    // Empty or a single track, streamed by the audio thread
+    std::vector<SceneMusic> music;
+
+    std::vector<SceneTransform> transforms;
+    std::vector<SceneRigidBody> rigidBodies;
+    std::vector<SceneSprite> sprites;
+    std::vector<SceneBoxCollider> boxColliders;
+    std::vector<SceneAnimation> animations;
+    std::vector<SceneCamera> cameras;
+    std::vector<SceneAudioSource> audioSources;
+    std::vector<SceneTextLabel> textLabels;
+    std::vector<SceneScript> scripts;
+    std::vector<SceneParent> parents;
+
+    // Only used while building the scene from Lua
+    std::unordered_map<std::string, uint32_t> stringIds;
+
+    uint32_t AddString(const std::string& value);
+    const std::string& GetString(uint32_t index) const;
+};
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Scene cache format /////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// [SceneFileHeader][strings: (uint32 length, chars)...]
+// [assets][clips][tilemaps][music][transforms]...[parents], each as (uint32 count,
+// records...) in the order of the Scene members. The header keeps a hash of
+// the Lua source the cache was built from, editing the scene rebuilds it.
+////////////////////////////////////////////////////////////////////////////
+struct SceneFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t entityCount;
+    uint32_t stringCount;
+};
+
+const char SCENE_FILE_MAGIC[4] = {'S', 'C', 'N', 'E'};
+const uint32_t SCENE_FILE_VERSION = 3;
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Scene Loader ///////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Scenes are Lua files returning a table with the assets and entities of a
+// level (see assets/scenes). The Lua is only run when there is no cache
+// next to it (same name, .scene extension) built from the same source, so
+// later runs read a few flat arrays instead of executing the script.
+////////////////////////////////////////////////////////////////////////////
+class SceneLoader {
+    private:
+        static bool BuildFromLua(const std::string& source, const std::string& scenePath, sol::state& lua, Scene& scene);
+        static bool ReadCache(const std::string& cachePath, uint64_t sourceHash, Scene& scene);
+        static bool WriteCache(const std::string& cachePath, uint64_t sourceHash, const Scene& scene);
+
+    public:
+        static std::string GetCachePath(const std::string& scenePath);
+
+        static bool Load(const std::string& scenePath, sol::state& lua, Scene& scene);
+        static void Instantiate(
+            const Scene& scene,
+            SDL_Renderer* renderer,
+            std::unique_ptr<AssetStore>& assetStore,
+            std::unique_ptr<Tilemap>& tilemap,
+            std::unique_ptr<AnimationLibrary>& animationLibrary,
+            std::unique_ptr<ScriptEngine>& scriptEngine,
+            std::unique_ptr<Registry>& registry
+        );
+};
+
+#endif
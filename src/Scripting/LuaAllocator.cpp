@@ -0,0 +1,112 @@
+#include "./LuaAllocator.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+static size_t GetSizeClass(size_t size) {
+    return (size - 1) / LUA_POOL_GRANULARITY;
+}
+
+LuaAllocator::LuaAllocator() {
+}
+
+LuaAllocator::~LuaAllocator() {
+    for (char* arena: arenas) {
+        std::free(arena);
+    }
+}
+
+/**
+ * lua_Alloc entry point, `userData` is the allocator
+*/
+void* LuaAllocator::Allocate(void* userData, void* block, size_t oldSize, size_t newSize) {
+    return static_cast<LuaAllocator*>(userData)->Reallocate(block, oldSize, newSize);
+}
+
+/**
+ * Same contract as lua_Alloc: frees when newSize is 0, returns nullptr on failure and leaves
+ * the old block untouched. When block is null, oldSize is a Lua type tag and not a size.
+*/
+void* LuaAllocator::Reallocate(void* block, size_t oldSize, size_t newSize) {
+    if (!block) {
+        oldSize = 0;
+    }
+
+    if (newSize == 0) {
+        if (block) {
+            ReleaseBlock(block, oldSize);
+            stats.bytesInUse -= oldSize;
+        }
+        return nullptr;
+    }
+
+    void* result = nullptr;
+    if (block && oldSize > LUA_POOL_MAX_BLOCK && newSize > LUA_POOL_MAX_BLOCK) {
+        // Both too big for the pools
+        result = std::realloc(block, newSize);
+    } else if (block && oldSize <= LUA_POOL_MAX_BLOCK && newSize <= LUA_POOL_MAX_BLOCK && GetSizeClass(oldSize) == GetSizeClass(newSize)) {
+        // Still fits in the same pool block
+        result = block;
+    } else {
+        result = AllocateBlock(newSize);
+        if (result && block) {
+            std::memcpy(result, block, std::min(oldSize, newSize));
+            ReleaseBlock(block, oldSize);
+        }
+    }
+
+    if (!result) {
+        return nullptr;
+    }
+
+    stats.bytesInUse = stats.bytesInUse - oldSize + newSize;
+    stats.peakBytes = std::max(stats.peakBytes, stats.bytesInUse);
+    stats.allocations++;
+    return result;
+}
+
+void* LuaAllocator::AllocateBlock(size_t size) {
+    if (size > LUA_POOL_MAX_BLOCK) {
+        return std::malloc(size);
+    }
+
+    stats.pooledAllocations++;
+    const size_t sizeClass = GetSizeClass(size);
+    if (freeLists[sizeClass]) {
+        FreeBlock* block = freeLists[sizeClass];
+        freeLists[sizeClass] = block->next;
+        return block;
+    }
+
+    const size_t blockSize = (sizeClass + 1) * LUA_POOL_GRANULARITY;
+    if (static_cast<size_t>(arenaEnd - arenaCursor) < blockSize) {
+        char* arena = static_cast<char*>(std::malloc(LUA_ARENA_SIZE));
+        if (!arena) {
+            return nullptr;
+        }
+        arenas.push_back(arena);
+        arenaCursor = arena;
+        arenaEnd = arena + LUA_ARENA_SIZE;
+        stats.arenaBytes += LUA_ARENA_SIZE;
+    }
+
+    void* block = arenaCursor;
+    arenaCursor += blockSize;
+    return block;
+}
+
+void LuaAllocator::ReleaseBlock(void* block, size_t size) {
+    if (size > LUA_POOL_MAX_BLOCK) {
+        std::free(block);
+        return;
+    }
+
+    FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+    const size_t sizeClass = GetSizeClass(size);
+    freeBlock->next = freeLists[sizeClass];
+    freeLists[sizeClass] = freeBlock;
+}
+
+const LuaAllocatorStats& LuaAllocator::GetStats() const {
+    return stats;
+}
@@ -0,0 +1,58 @@
+#ifndef LUAALLOCATOR_H
+#define LUAALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Blocks up to LUA_POOL_MAX_BLOCK bytes come from pools in steps of LUA_POOL_GRANULARITY bytes
+const size_t LUA_POOL_GRANULARITY = 16;
+const size_t LUA_POOL_MAX_BLOCK = 256;
+const size_t LUA_POOL_CLASSES = LUA_POOL_MAX_BLOCK / LUA_POOL_GRANULARITY;
+// Pools are carved out of arenas of this size
+const size_t LUA_ARENA_SIZE = 64 * 1024;
+
+struct LuaAllocatorStats {
+    // What Lua asked for, not counting pool rounding
+    size_t bytesInUse;
+    size_t peakBytes;
+    size_t arenaBytes;
+    uint64_t allocations;
+    uint64_t pooledAllocations;
+};
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Lua Allocator //////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Allocator for the Lua state (lua_Alloc). Almost everything Lua allocates
+// is small (strings, tables, closures, upvalues), so small blocks come from
+// free lists per size class backed by big arenas and never reach malloc.
+// Lua passes the old size of every block it frees, so blocks don't need a
+// header. Arenas are only given back when the allocator goes away.
+////////////////////////////////////////////////////////////////////////////
+class LuaAllocator {
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        FreeBlock* freeLists[LUA_POOL_CLASSES] = {};
+        std::vector<char*> arenas;
+        char* arenaCursor = nullptr;
+        char* arenaEnd = nullptr;
+        LuaAllocatorStats stats = {};
+
+        void* AllocateBlock(size_t size);
+        void ReleaseBlock(void* block, size_t size);
+
+    public:
+        LuaAllocator();
+        ~LuaAllocator();
+
+        static void* Allocate(void* userData, void* block, size_t oldSize, size_t newSize);
+        void* Reallocate(void* block, size_t oldSize, size_t newSize);
+
+        const LuaAllocatorStats& GetStats() const;
+};
+
+#endif
@@ -0,0 +1,712 @@
+#include "./ScriptEngine.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/SpriteComponent.h"
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Script Batch /////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+int ScriptBatch::Size() const {
+    return static_cast<int>(entities.size());
+}
+
+/**
+ * An index outside of the batch is a bug in the script, so it is raised as a Lua error (sol
+ * turns the exception into one) instead of reading past the entities. A resumed script
+ * carries on with this frame's batch, its loops have to check size() again.
+*/
+static const Entity& GetBatchEntity(const ScriptBatch& batch, int index) {
+    if (index < 1 || index > batch.Size()) {
+        throw sol::error("entity index " + std::to_string(index) + " is out of the batch (1 to " + std::to_string(batch.Size()) + ")");
+    }
+    return batch.entities[index - 1];
+}
+
+int ScriptBatch::GetEntityId(int index) const {
+    return GetBatchEntity(*this, index).GetId();
+}
+
+TransformComponent* ScriptBatch::GetTransform(int index) const {
+    return &GetBatchEntity(*this, index).GetComponent<TransformComponent>();
+}
+
+RigidBodyComponent* ScriptBatch::GetRigidBody(int index) const {
+    const Entity& entity = GetBatchEntity(*this, index);
+    return entity.HasComponent<RigidBodyComponent>() ? &entity.GetComponent<RigidBodyComponent>() : nullptr;
+}
+
+SpriteComponent* ScriptBatch::GetSprite(int index) const {
+    const Entity& entity = GetBatchEntity(*this, index);
+    return entity.HasComponent<SpriteComponent>() ? &entity.GetComponent<SpriteComponent>() : nullptr;
+}
+
+Entity ScriptBatch::GetEntity(int index) const {
+    return GetBatchEntity(*this, index);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Entity ///////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+// Script-defined components of an entity, by component and field name
+
+static double ToColumnValue(const sol::object& value) {
+    return value.is<bool>() ? (value.as<bool>() ? 1.0 : 0.0) : value.as<double>();
+}
+
+static bool EntityHasColumn(const Entity& entity, const std::string& name) {
+    return entity.registry->EntityHasComponent(entity, entity.registry->GetColumnComponentId(name));
+}
+
+static void EntityAddColumn(const Entity& entity, const std::string& name, sol::optional<sol::table> values) {
+    const int componentId = entity.registry->GetColumnComponentId(name);
+    const int index = entity.registry->AddColumnComponentToEntity(entity, componentId);
+    if (index < 0) {
+        Logger::Err("Can't add unknown component " + name);
+        return;
+    }
+    if (!values) {
+        return;
+    }
+    ColumnPool* pool = entity.registry->GetColumnPool(componentId);
+    for (const auto& value: *values) {
+        const int field = pool->GetFieldIndex(value.first.as<std::string>());
+        if (field >= 0) {
+            pool->SetValue(field, index, ToColumnValue(value.second));
+        }
+    }
+}
+
+static void EntityRemoveColumn(const Entity& entity, const std::string& name) {
+    entity.registry->RemoveColumnComponentFromEntity(entity, entity.registry->GetColumnComponentId(name));
+}
+
+static sol::object EntityGetColumn(const Entity& entity, const std::string& name, const std::string& fieldName, sol::this_state state) {
+    ColumnPool* pool = entity.registry->GetColumnPool(entity.registry->GetColumnComponentId(name));
+    const int index = pool ? pool->GetIndex(entity.GetId()) : -1;
+    const int field = pool ? pool->GetFieldIndex(fieldName) : -1;
+    if (index < 0 || field < 0) {
+        return sol::lua_nil;
+    }
+    const double value = pool->GetValue(field, index);
+    if (pool->GetFields()[field].type == COLUMN_BOOL) {
+        return sol::make_object(state, value != 0);
+    }
+    return sol::make_object(state, value);
+}
+
+static void EntitySetColumn(const Entity& entity, const std::string& name, const std::string& fieldName, sol::object value) {
+    ColumnPool* pool = entity.registry->GetColumnPool(entity.registry->GetColumnComponentId(name));
+    const int index = pool ? pool->GetIndex(entity.GetId()) : -1;
+    const int field = pool ? pool->GetFieldIndex(fieldName) : -1;
+    if (index >= 0 && field >= 0) {
+        pool->SetValue(field, index, ToColumnValue(value));
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Component View ///////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+int ComponentView::Size() const {
+    return pool->GetSize();
+}
+
+sol::optional<Entity> ComponentView::GetEntity(int index) const {
+    if (index < 1 || index > pool->GetSize()) {
+        return sol::nullopt;
+    }
+    Entity entity(pool->GetEntityId(index - 1));
+    entity.registry = registry;
+    return entity;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Script Engine ////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+double ScriptEngine::budgetDeadlineMs = 0;
+int ScriptEngine::budgetHooksLeft = -1;
+bool ScriptEngine::budgetExceeded = false;
+
+ScriptEngine::ScriptEngine(Registry* registry): lua(sol::default_at_panic, &LuaAllocator::Allocate, &allocator), registry(registry) {
+    // Collection only happens in the steps given by CollectGarbage()
+    lua_gc(lua.lua_state(), LUA_GCSTOP, 0);
+    #if LUA_VERSION_NUM >= 504
+        lua_gc(lua.lua_state(), LUA_GCINC, 0, 0, 0);
+    #endif
+    gcSampleId = Profiler::GetSampleId("Lua GC");
+
+    lua.open_libraries(sol::lib::base, sol::lib::math, sol::lib::string, sol::lib::table);
+    BindComponents();
+    BindScheduler();
+    BindColumnComponents();
+    Logger::Success("ScriptEngine constructor called!");
+}
+
+ScriptEngine::~ScriptEngine() {
+    Clear();
+    Logger::Success("ScriptEngine destructor called!");
+}
+
+/**
+ * Exposes the component structs to Lua. Fields are bound straight to the members,
+ * so `transform.position.x = 10` writes into the component pool without any copies.
+*/
+void ScriptEngine::BindComponents() {
+    lua.new_usertype<glm::vec2>(
+        "vec2",
+        sol::constructors<glm::vec2(), glm::vec2(float, float)>(),
+        "x", &glm::vec2::x,
+        "y", &glm::vec2::y
+    );
+
+    lua.new_usertype<TransformComponent>(
+        "Transform",
+        sol::no_constructor,
+        "position", &TransformComponent::position,
+        "scale", &TransformComponent::scale,
+        "rotation", &TransformComponent::rotation
+    );
+
+    lua.new_usertype<RigidBodyComponent>(
+        "RigidBody",
+        sol::no_constructor,
+        "velocity", &RigidBodyComponent::velocity
+    );
+
+    lua.new_usertype<SpriteComponent>(
+        "Sprite",
+        sol::no_constructor,
+        "asset_id", &SpriteComponent::assetId,
+        "width", &SpriteComponent::width,
+        "height", &SpriteComponent::height
+    );
+
+    // Handle given to behaviors, same accessors as the batch without the index
+    lua.new_usertype<Entity>(
+        "Entity",
+        sol::no_constructor,
+        "id", &Entity::GetId,
+        "transform", [](const Entity& entity) -> TransformComponent* {
+            return entity.HasComponent<TransformComponent>() ? &entity.GetComponent<TransformComponent>() : nullptr;
+        },
+        "rigidbody", [](const Entity& entity) -> RigidBodyComponent* {
+            return entity.HasComponent<RigidBodyComponent>() ? &entity.GetComponent<RigidBodyComponent>() : nullptr;
+        },
+        "sprite", [](const Entity& entity) -> SpriteComponent* {
+            return entity.HasComponent<SpriteComponent>() ? &entity.GetComponent<SpriteComponent>() : nullptr;
+        },
+        "has", &EntityHasColumn,
+        "add", &EntityAddColumn,
+        "remove", &EntityRemoveColumn,
+        "get", &EntityGetColumn,
+        "set", &EntitySetColumn
+    );
+
+    lua.new_usertype<ScriptBatch>(
+        "EntityBatch",
+        sol::no_constructor,
+        "size", &ScriptBatch::Size,
+        "id", &ScriptBatch::GetEntityId,
+        "transform", &ScriptBatch::GetTransform,
+        "rigidbody", &ScriptBatch::GetRigidBody,
+        "sprite", &ScriptBatch::GetSprite,
+        "entity", &ScriptBatch::GetEntity
+    );
+}
+
+template <typename TView>
+static void BindColumnView(sol::state& lua, const char* name) {
+    lua.new_usertype<TView>(
+        name,
+        sol::no_constructor,
+        "size", &TView::Size,
+        "get", &TView::Get,
+        "set", &TView::Set
+    );
+}
+
+/**
+ * Lua side of the runtime components. Entities look components up by name, views resolve
+ * the pool and field once so loops over them are plain array accesses.
+*/
+void ScriptEngine::BindColumnComponents() {
+    BindColumnView<FloatColumnView>(lua, "FloatColumn");
+    BindColumnView<IntColumnView>(lua, "IntColumn");
+    BindColumnView<BoolColumnView>(lua, "BoolColumn");
+
+    lua.new_usertype<ComponentView>(
+        "ComponentView",
+        sol::no_constructor,
+        "size", &ComponentView::Size,
+        "entity", &ComponentView::GetEntity,
+        "column", [](const ComponentView& view, const std::string& fieldName, sol::this_state state) -> sol::object {
+            const int field = view.pool->GetFieldIndex(fieldName);
+            if (field < 0) {
+                return sol::lua_nil;
+            }
+            switch (view.pool->GetFields()[field].type) {
+                case COLUMN_FLOAT: return sol::make_object(state, FloatColumnView{ view.pool, field });
+                case COLUMN_INT: return sol::make_object(state, IntColumnView{ view.pool, field });
+                case COLUMN_BOOL: return sol::make_object(state, BoolColumnView{ view.pool, field });
+            }
+            return sol::lua_nil;
+        }
+    );
+
+    // Fields are sorted by name so the layout doesn't depend on Lua's table order
+    lua.set_function("define_component", [this](const std::string& name, sol::table layout) -> int {
+        std::vector<ColumnField> fields;
+        for (const auto& entry: layout) {
+            const std::string fieldName = entry.first.as<std::string>();
+            const std::string typeName = entry.second.as<std::string>();
+            ColumnField field;
+            field.name = fieldName;
+            if (typeName == "float") {
+                field.type = COLUMN_FLOAT;
+            } else if (typeName == "int") {
+                field.type = COLUMN_INT;
+            } else if (typeName == "bool") {
+                field.type = COLUMN_BOOL;
+            } else {
+                Logger::Err("Component " + name + " field " + fieldName + " has unknown type " + typeName);
+                return -1;
+            }
+            fields.push_back(field);
+        }
+        std::sort(fields.begin(), fields.end(), [](const ColumnField& a, const ColumnField& b) {
+            return a.name < b.name;
+        });
+        return registry->RegisterColumnComponent(name, fields);
+    });
+
+    lua.set_function("component_view", [this](const std::string& name) -> sol::optional<ComponentView> {
+        ColumnPool* pool = registry->GetColumnPool(registry->GetColumnComponentId(name));
+        if (!pool) {
+            return sol::nullopt;
+        }
+        return ComponentView{ pool, registry };
+    });
+}
+
+// wait(seconds): suspends the behavior until the time has passed
+static int LuaWait(lua_State* L) {
+    const lua_Number seconds = luaL_checknumber(L, 1);
+    lua_pushinteger(L, SCRIPT_WAKE_TIMER);
+    lua_pushnumber(L, seconds);
+    return lua_yield(L, 2);
+}
+
+// wait_until(event): suspends the behavior until the event is signaled
+static int LuaWaitUntil(lua_State* L) {
+    luaL_checkstring(L, 1);
+    lua_pushinteger(L, SCRIPT_WAKE_EVENT);
+    lua_pushvalue(L, 1);
+    return lua_yield(L, 2);
+}
+
+/**
+ * wait and wait_until are plain C functions so they can yield straight out of the coroutine
+*/
+void ScriptEngine::BindScheduler() {
+    lua_register(lua.lua_state(), "wait", &LuaWait);
+    lua_register(lua.lua_state(), "wait_until", &LuaWaitUntil);
+    lua.set_function("signal", [this](const std::string& event) {
+        Signal(event);
+    });
+}
+
+/**
+ * Runs the script file in a fresh environment and keeps its update and behavior functions.
+ * Loading an id that is already loaded reloads it in place.
+*/
+bool ScriptEngine::LoadScript(const std::string& scriptId, const std::string& filePath) {
+    sol::environment environment(lua, sol::create, lua.globals());
+
+    sol::protected_function_result result = lua.safe_script_file(filePath, environment, sol::script_pass_on_error);
+    if (!result.valid()) {
+        sol::error error = result;
+        Logger::Err("Error loading script " + filePath + ": " + error.what());
+        return false;
+    }
+
+    sol::protected_function update = environment["update"];
+    sol::protected_function behavior = environment["behavior"];
+    if (!update.valid() && !behavior.valid()) {
+        Logger::Err("Script " + filePath + " has no update(entities, deltaTime) or behavior(entity) function");
+        return false;
+    }
+
+    Script script;
+    script.scriptId = scriptId;
+    script.environment = environment;
+    script.update = update;
+    script.behavior = behavior;
+    script.budgetMs = environment.get_or("budget_ms", SCRIPT_BUDGET_MS);
+    script.resumable = environment.get_or("resumable", false);
+    script.suspended = false;
+    script.overruns = 0;
+    script.sampleId = Profiler::GetSampleId("Script " + scriptId);
+
+    auto existing = scriptIds.find(scriptId);
+    if (existing != scriptIds.end()) {
+        scripts[existing->second] = script;
+    } else {
+        scriptIds.insert(std::make_pair(scriptId, static_cast<int>(scripts.size())));
+        scripts.push_back(script);
+    }
+
+    Logger::Success("Script " + scriptId + " loaded from " + filePath);
+    return true;
+}
+
+/**
+ * Returns -1 if there is no script with that id
+*/
+int ScriptEngine::GetScriptId(const std::string& scriptId) const {
+    auto script = scriptIds.find(scriptId);
+    return script != scriptIds.end() ? script->second : -1;
+}
+
+int ScriptEngine::GetScriptCount() const {
+    return static_cast<int>(scripts.size());
+}
+
+int ScriptEngine::GetOverruns(int scriptIndex) const {
+    return scripts[scriptIndex].overruns;
+}
+
+bool ScriptEngine::HasUpdate(int scriptIndex) const {
+    return scripts[scriptIndex].update.valid();
+}
+
+bool ScriptEngine::HasBehavior(int scriptIndex) const {
+    return scripts[scriptIndex].behavior.valid();
+}
+
+/**
+ * Counts the budget in instructions rather than time, so a script stops at the same point
+ * on every run whatever the machine. Used while recording or playing a replay.
+*/
+void ScriptEngine::SetCountedBudget(bool counted) {
+    countedBudget = counted;
+}
+
+void ScriptEngine::StartBudget(const Script& script, double start) {
+    budgetDeadlineMs = start + script.budgetMs;
+    budgetHooksLeft = countedBudget ? std::max(1, static_cast<int>(script.budgetMs * SCRIPT_INSTRUCTIONS_PER_MS / SCRIPT_HOOK_INSTRUCTIONS)) : -1;
+    budgetExceeded = false;
+}
+
+/**
+ * Checks the running script against its budget every SCRIPT_HOOK_INSTRUCTIONS instructions.
+ * Yields when the script runs in a coroutine that can yield, raises an error otherwise.
+*/
+void ScriptEngine::BudgetHook(lua_State* L, lua_Debug* /* debug */) {
+    if (budgetHooksLeft >= 0 ? --budgetHooksLeft > 0 : Profiler::NowMs() < budgetDeadlineMs) {
+        return;
+    }
+    budgetExceeded = true;
+    if (lua_isyieldable(L)) {
+        lua_yield(L, 0);
+        return;
+    }
+    luaL_error(L, "script ran over its time budget");
+}
+
+/**
+ * Calls the script's update once for the whole batch, or resumes it if it was suspended
+ * on the previous frame. A script that errors is disabled until it is loaded again, rather
+ * than logging the same error every frame.
+*/
+void ScriptEngine::RunBatch(int scriptIndex, ScriptBatch& batch, double deltaTime) {
+    Script& script = scripts[scriptIndex];
+    if (!script.update.valid()) {
+        return;
+    }
+
+    const double start = Profiler::NowMs();
+    StartBudget(script, start);
+
+    const bool ok = script.resumable ? CallResumable(script, batch, deltaTime) : CallProtected(script, batch, deltaTime);
+
+    if (budgetExceeded) {
+        ReportOverrun(script, script.resumable ? "suspended" : "aborted");
+    } else if (!ok) {
+        script.update = sol::lua_nil;
+        script.thread = sol::thread();
+        script.suspended = false;
+    }
+
+    Profiler::Record(script.sampleId, Profiler::NowMs() - start);
+}
+
+void ScriptEngine::ReportOverrun(Script& script, const char* outcome) {
+    script.overruns++;
+    if (script.overruns % SCRIPT_OVERRUN_LOG_INTERVAL == 1) {
+        Logger::Err(
+            "Script " + script.scriptId + " ran over its " + std::to_string(script.budgetMs) + " ms budget and was " +
+            outcome + " (" + std::to_string(script.overruns) + " times)"
+        );
+    }
+}
+
+/**
+ * Resumes a coroutine under the budget of the running script. What it yielded or returned
+ * is left on its stack and counted in `resultCount`. Nothing else may be popped from a
+ * coroutine that yielded from the hook, its stack is the suspended function's registers.
+*/
+int ScriptEngine::Resume(lua_State* coroutine, int argumentCount, int& resultCount) {
+    lua_sethook(coroutine, &ScriptEngine::BudgetHook, LUA_MASKCOUNT, SCRIPT_HOOK_INSTRUCTIONS);
+    #if LUA_VERSION_NUM >= 504
+        const int status = lua_resume(coroutine, lua.lua_state(), argumentCount, &resultCount);
+    #else
+        const int status = lua_resume(coroutine, lua.lua_state(), argumentCount);
+        resultCount = (status == LUA_YIELD && budgetExceeded) ? 0 : lua_gettop(coroutine);
+    #endif
+    lua_sethook(coroutine, nullptr, 0, 0);
+    return status;
+}
+
+bool ScriptEngine::CallProtected(Script& script, ScriptBatch& batch, double deltaTime) {
+    lua_State* L = lua.lua_state();
+    lua_sethook(L, &ScriptEngine::BudgetHook, LUA_MASKCOUNT, SCRIPT_HOOK_INSTRUCTIONS);
+    sol::protected_function_result result = script.update(std::ref(batch), deltaTime);
+    lua_sethook(L, nullptr, 0, 0);
+
+    if (!result.valid() && !budgetExceeded) {
+        sol::error error = result;
+        Logger::Err("Script " + script.scriptId + " failed and was disabled: " + error.what());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Runs update in the script's coroutine. A suspended coroutine is resumed where it stopped
+ * instead of starting a new call, it finishes last frame's work with this frame's batch.
+*/
+bool ScriptEngine::CallResumable(Script& script, ScriptBatch& batch, double deltaTime) {
+    int argumentCount = 0;
+    if (!script.suspended) {
+        script.thread = sol::thread::create(lua.lua_state());
+        lua_State* coroutine = script.thread.thread_state();
+        script.update.push(coroutine);
+        sol::stack::push(coroutine, &batch);
+        lua_pushnumber(coroutine, deltaTime);
+        argumentCount = 2;
+    }
+
+    lua_State* coroutine = script.thread.thread_state();
+    int resultCount = 0;
+    const int status = Resume(coroutine, argumentCount, resultCount);
+
+    if (status == LUA_YIELD) {
+        script.suspended = true;
+        lua_pop(coroutine, resultCount);
+        return true;
+    }
+
+    script.suspended = false;
+    if (status != LUA_OK) {
+        const char* message = lua_tostring(coroutine, -1);
+        Logger::Err("Script " + script.scriptId + " failed and was disabled: " + (message ? message : "unknown error"));
+        return false;
+    }
+    lua_settop(coroutine, 0);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Behaviors ////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Starts the script's behavior for the entity and runs it up to its first wait
+*/
+void ScriptEngine::StartBehavior(int scriptIndex, Entity entity) {
+    int taskIndex;
+    if (!freeTasks.empty()) {
+        taskIndex = freeTasks.back();
+        freeTasks.pop_back();
+    } else {
+        taskIndex = static_cast<int>(tasks.size());
+        tasks.emplace_back();
+    }
+
+    ScriptTask& task = tasks[taskIndex];
+    task.thread = sol::thread::create(lua.lua_state());
+    task.scriptIndex = scriptIndex;
+    task.active = true;
+
+    lua_State* coroutine = task.thread.thread_state();
+    scripts[scriptIndex].behavior.push(coroutine);
+    sol::stack::push(coroutine, entity);
+    ResumeTask(taskIndex, 1);
+}
+
+/**
+ * Resumes the task and files it under whatever it waits for next. Finished and failed
+ * tasks go back to the free list.
+*/
+void ScriptEngine::ResumeTask(int taskIndex, int argumentCount) {
+    Script& script = scripts[tasks[taskIndex].scriptIndex];
+    lua_State* coroutine = tasks[taskIndex].thread.thread_state();
+
+    const double start = Profiler::NowMs();
+    StartBudget(script, start);
+
+    int resultCount = 0;
+    const int status = Resume(coroutine, argumentCount, resultCount);
+    Profiler::Record(script.sampleId, Profiler::NowMs() - start);
+    resumeCount++;
+
+    if (status == LUA_YIELD) {
+        int wakeType = 0;
+        if (resultCount == 2) {
+            wakeType = static_cast<int>(lua_tointeger(coroutine, -2));
+        }
+
+        if (wakeType == SCRIPT_WAKE_TIMER) {
+            timers.push_back({ schedulerClock + lua_tonumber(coroutine, -1), taskIndex });
+            std::push_heap(timers.begin(), timers.end());
+        } else if (wakeType == SCRIPT_WAKE_EVENT) {
+            eventWaiters[lua_tostring(coroutine, -1)].push_back(taskIndex);
+        } else {
+            // Out of budget, carries on next frame
+            if (budgetExceeded) {
+                ReportOverrun(script, "suspended");
+            }
+            readyTasks.push_back(taskIndex);
+        }
+        lua_pop(coroutine, resultCount);
+        return;
+    }
+
+    if (status != LUA_OK) {
+        const char* message = lua_tostring(coroutine, -1);
+        Logger::Err("Behavior of script " + script.scriptId + " failed: " + (message ? message : "unknown error"));
+    }
+
+    ScriptTask& task = tasks[taskIndex];
+    task.thread = sol::thread();
+    task.active = false;
+    freeTasks.push_back(taskIndex);
+}
+
+/**
+ * Advances the scheduler clock and resumes the tasks whose timer ran out or whose event
+ * was signaled. Everything else is left alone.
+*/
+void ScriptEngine::ResumeTasks(double deltaTime) {
+    schedulerClock += deltaTime;
+
+    resumingTasks.clear();
+    resumingTasks.swap(readyTasks);
+    while (!timers.empty() && timers.front().wakeTime <= schedulerClock) {
+        resumingTasks.push_back(timers.front().taskIndex);
+        std::pop_heap(timers.begin(), timers.end());
+        timers.pop_back();
+    }
+
+    for (int taskIndex: resumingTasks) {
+        if (tasks[taskIndex].active) {
+            ResumeTask(taskIndex, 0);
+        }
+    }
+}
+
+/**
+ * Wakes every behavior waiting for the event, they run on the next ResumeTasks()
+*/
+void ScriptEngine::Signal(const std::string& event) {
+    auto waiters = eventWaiters.find(event);
+    if (waiters == eventWaiters.end() || waiters->second.empty()) {
+        return;
+    }
+    readyTasks.insert(readyTasks.end(), waiters->second.begin(), waiters->second.end());
+    waiters->second.clear();
+}
+
+int ScriptEngine::GetTaskCount() const {
+    return static_cast<int>(tasks.size() - freeTasks.size());
+}
+
+int ScriptEngine::GetResumeCount() const {
+    return resumeCount;
+}
+
+/**
+ * Drops every behavior and suspended update, for when the entities they were working on
+ * are replaced (see Registry::LoadSnapshot). The scheduler clock starts over.
+*/
+void ScriptEngine::StopBehaviors() {
+    tasks.clear();
+    freeTasks.clear();
+    timers.clear();
+    eventWaiters.clear();
+    readyTasks.clear();
+    resumingTasks.clear();
+    schedulerClock = 0;
+    for (Script& script: scripts) {
+        script.thread = sol::thread();
+        script.suspended = false;
+    }
+}
+
+/**
+ * Advances the incremental collector until the cycle finishes or `budgetMs` runs out.
+ * At least one step is always done so collection keeps up with allocation.
+*/
+void ScriptEngine::CollectGarbage(double budgetMs) {
+    const double start = Profiler::NowMs();
+    double elapsed = 0;
+    do {
+        // Returns 1 when the step finished a cycle
+        if (lua_gc(lua.lua_state(), LUA_GCSTEP, SCRIPT_GC_STEP_KB) != 0) {
+            break;
+        }
+        elapsed = Profiler::NowMs() - start;
+    } while (elapsed < budgetMs);
+
+    Profiler::Record(gcSampleId, Profiler::NowMs() - start);
+}
+
+/**
+ * Seeds math.random for the scripts, so runs that share a seed (replays) share the numbers
+*/
+void ScriptEngine::SetRandomSeed(uint32_t seed) {
+    lua["math"]["randomseed"](seed);
+}
+
+sol::state& ScriptEngine::GetState() {
+    return lua;
+}
+
+const LuaAllocator& ScriptEngine::GetAllocator() const {
+    return allocator;
+}
+
+void ScriptEngine::Clear() {
+    for (const Script& script: scripts) {
+        if (script.overruns > 0) {
+            Logger::Log("Script " + script.scriptId + " ran over its budget " + std::to_string(script.overruns) + " times");
+        }
+    }
+    StopBehaviors();
+    scripts.clear();
+    scriptIds.clear();
+    lua.collect_garbage();
+
+    const LuaAllocatorStats& stats = allocator.GetStats();
+    Logger::Log(
+        "Lua heap: " + std::to_string(stats.bytesInUse / 1024) + " KB in use, " +
+        std::to_string(stats.peakBytes / 1024) + " KB peak, " +
+        std::to_string(stats.arenaBytes / 1024) + " KB of pool arenas, " +
+        std::to_string(stats.pooledAllocations) + " of " + std::to_string(stats.allocations) + " allocations pooled"
+    );
+}
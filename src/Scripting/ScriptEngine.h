@@ -0,0 +1,229 @@
+#ifndef SCRIPTENGINE_H
+#define SCRIPTENGINE_H
+
+// sol 3.2 uses std::numeric_limits without including <limits>, newer compilers need it first
+#include <limits>
+#include <sol/sol.hpp>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../ECS/ECS.h"
+#include "./LuaAllocator.h"
+
+// Time a script gets per call unless it sets its own `budget_ms`
+const double SCRIPT_BUDGET_MS = 2.0;
+// How often the budget is checked while a script runs, in Lua instructions
+const int SCRIPT_HOOK_INSTRUCTIONS = 1000;
+// Instructions a millisecond of budget is worth when the budget is counted instead of timed
+const int SCRIPT_INSTRUCTIONS_PER_MS = 100000;
+// Overruns are logged the first time and then once every this many
+const int SCRIPT_OVERRUN_LOG_INTERVAL = 100;
+
+// What a behavior coroutine yielded for, pushed by wait() and wait_until()
+enum ScriptWakeType {
+    SCRIPT_WAKE_TIMER = 1,
+    SCRIPT_WAKE_EVENT = 2
+};
+
+// Time the Lua garbage collector gets every frame
+const double SCRIPT_GC_BUDGET_MS = 0.5;
+// Work done by each incremental collector step, in KB of allocation
+const int SCRIPT_GC_STEP_KB = 8;
+
+struct TransformComponent;
+struct RigidBodyComponent;
+struct SpriteComponent;
+
+/**
+ * All the entities that run the same script this frame. Lua gets the whole batch in one
+ * call and reaches into the components through it, indices start at 1 like any Lua array.
+ * Components are handed out by reference, so writes go straight to the pools. An index
+ * outside of 1 to size() raises a Lua error.
+*/
+struct ScriptBatch {
+    std::vector<Entity> entities;
+
+    int Size() const;
+    int GetEntityId(int index) const;
+    TransformComponent* GetTransform(int index) const;
+    // nil in Lua when the entity doesn't have one
+    RigidBodyComponent* GetRigidBody(int index) const;
+    SpriteComponent* GetSprite(int index) const;
+    Entity GetEntity(int index) const;
+};
+
+/**
+ * One field of a script-defined component, read and written straight in its ColumnPool
+ * column. Indices are the 1-based dense order of the component view it came from.
+*/
+template <typename TValue, typename TStored>
+struct ColumnView {
+    ColumnPool* pool;
+    int field;
+
+    int Size() const {
+        return pool->GetSize();
+    }
+
+    TValue Get(int index) const {
+        return index >= 1 && index <= pool->GetSize() ? static_cast<TValue>(pool->ReadColumn<TStored>(field)[index - 1]) : TValue();
+    }
+
+    void Set(int index, TValue value) {
+        if (index >= 1 && index <= pool->GetSize()) {
+            pool->SetValue(field, index - 1, static_cast<double>(value));
+        }
+    }
+};
+
+typedef ColumnView<float, float> FloatColumnView;
+typedef ColumnView<int, int32_t> IntColumnView;
+typedef ColumnView<bool, uint8_t> BoolColumnView;
+
+/**
+ * Every entity that has a script-defined component, in the order they are stored
+*/
+struct ComponentView {
+    ColumnPool* pool;
+    Registry* registry;
+
+    int Size() const;
+    sol::optional<Entity> GetEntity(int index) const;
+};
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Script Engine //////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Owns the Lua state and the loaded scripts. Every script runs in its own
+// environment so their globals don't step on each other, and exposes an
+//   update(entities, deltaTime)
+// function that is called once per frame with every entity using it.
+// Scripts that set `resumable = true` run their update in a coroutine.
+// Crossing into Lua costs the same for one entity or a thousand, so
+// batching keeps the boundary out of the per-entity cost.
+//
+// Lua memory comes from a pooled LuaAllocator and the automatic garbage
+// collector is off. Instead CollectGarbage() runs incremental steps once a
+// frame until its time budget is spent, so collection is spread evenly over
+// the frames instead of landing as a pause whenever Lua decides.
+//
+// Every call runs under a time budget checked from an instruction count
+// hook. A resumable script that runs out is suspended and picks up where it
+// was on the next frame, any other script is aborted. Overruns are counted
+// and each script's time goes to the profiler under its own name. Where a
+// script stops then depends on how fast the machine is, so runs that are
+// recorded or replayed count the budget in instructions instead.
+//
+// Scripts can also define `behavior(entity)`, started as one coroutine per
+// entity that can `wait(seconds)` or `wait_until(event)`. Sleeping ones sit
+// in a timer heap or in the waiter list of their event and are only touched
+// again when they wake up, so idle behaviors cost nothing per frame. Events
+// come from `signal(event)` in Lua or Signal() in C++.
+//
+// Components with fields only known by a script are registered with
+// `define_component(name, { field = "float" | "int" | "bool" })`. They get
+// a real component id and live in a ColumnPool, `entity:add(name, values)`
+// attaches one and `component_view(name):column(field)` walks a field of all
+// of them in storage order.
+////////////////////////////////////////////////////////////////////////////
+class ScriptEngine {
+    private:
+        struct Script {
+            std::string scriptId;
+            sol::environment environment;
+            sol::protected_function update;
+            sol::protected_function behavior;
+            double budgetMs;
+            bool resumable;
+            // Coroutine of a resumable script, kept while it is suspended
+            sol::thread thread;
+            bool suspended;
+            int overruns;
+            int sampleId;
+        };
+
+        // A running behavior coroutine, tasks are reused once they finish
+        struct ScriptTask {
+            sol::thread thread;
+            int scriptIndex;
+            bool active;
+        };
+
+        struct ScriptTimer {
+            double wakeTime;
+            int taskIndex;
+
+            // Makes the heap a min-heap on wake time
+            bool operator <(const ScriptTimer& other) const { return wakeTime > other.wakeTime; }
+        };
+
+        // Budget of the script that is running, read by the hook
+        static double budgetDeadlineMs;
+        // Hook calls left when the budget is counted in instructions, -1 when it's timed
+        static int budgetHooksLeft;
+        static bool budgetExceeded;
+        static void BudgetHook(lua_State* L, lua_Debug* debug);
+
+        // Declared before the state so it is still there when the state closes
+        LuaAllocator allocator;
+        // Declared before the scripts so it outlives every reference they hold into it
+        sol::state lua;
+        Registry* registry;
+        int gcSampleId;
+        std::vector<Script> scripts;
+        std::unordered_map<std::string, int> scriptIds;
+        bool countedBudget = false;
+
+        // Behavior scheduler. Coroutines can't be copied, so neither the tasks nor the clock
+        // their timers are set on are rolled back with the Registry (see Game::Resimulate)
+        double schedulerClock = 0;
+        std::vector<ScriptTask> tasks;
+        std::vector<int> freeTasks;
+        std::vector<ScriptTimer> timers;
+        std::unordered_map<std::string, std::vector<int>> eventWaiters;
+        // Tasks to resume on the next ResumeTasks(), and the ones being resumed now
+        std::vector<int> readyTasks;
+        std::vector<int> resumingTasks;
+        // Only ever grows, tells whether any behavior ran between two points in time
+        int resumeCount = 0;
+
+        void BindComponents();
+        void BindScheduler();
+        void BindColumnComponents();
+        void StartBudget(const Script& script, double start);
+        int Resume(lua_State* coroutine, int argumentCount, int& resultCount);
+        void ReportOverrun(Script& script, const char* outcome);
+        void ResumeTask(int taskIndex, int argumentCount);
+        bool CallProtected(Script& script, ScriptBatch& batch, double deltaTime);
+        bool CallResumable(Script& script, ScriptBatch& batch, double deltaTime);
+
+    public:
+        ScriptEngine(Registry* registry);
+        ~ScriptEngine();
+
+        bool LoadScript(const std::string& scriptId, const std::string& filePath);
+        int GetScriptId(const std::string& scriptId) const;
+        int GetScriptCount() const;
+        int GetOverruns(int scriptIndex) const;
+        bool HasUpdate(int scriptIndex) const;
+        bool HasBehavior(int scriptIndex) const;
+
+        void RunBatch(int scriptIndex, ScriptBatch& batch, double deltaTime);
+        void CollectGarbage(double budgetMs);
+
+        void StartBehavior(int scriptIndex, Entity entity);
+        void ResumeTasks(double deltaTime);
+        void Signal(const std::string& event);
+        int GetTaskCount() const;
+        int GetResumeCount() const;
+        void StopBehaviors();
+
+        void SetRandomSeed(uint32_t seed);
+        void SetCountedBudget(bool counted);
+
+        sol::state& GetState();
+        const LuaAllocator& GetAllocator() const;
+        void Clear();
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include <cmath>
+#include <glm/glm.hpp>
+#include <SDL2/SDL.h>
+#include "../Components/TransformComponent.h"
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// AABB ///////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Axis aligned bounding box in world coordinates. Used for every "is this
+// thing near that thing" question (culling, spatial queries, broadphase)
+// so all of them agree on what the extents of an entity are.
+////////////////////////////////////////////////////////////////////////////
+struct AABB {
+    float minX = 0;
+    float minY = 0;
+    float maxX = 0;
+    float maxY = 0;
+
+    bool Intersects(const AABB& other) const {
+        return minX <= other.maxX && maxX >= other.minX &&
+               minY <= other.maxY && maxY >= other.minY;
+    }
+
+    static AABB FromRect(const SDL_Rect& rect) {
+        return {
+            static_cast<float>(rect.x),
+            static_cast<float>(rect.y),
+            static_cast<float>(rect.x + rect.w),
+            static_cast<float>(rect.y + rect.h)
+        };
+    }
+};
+
+/**
+ * Bounds of a sprite of the given size once the transform is applied.
+ * SDL_RenderCopyEx rotates around the center of the destination rect, so we
+ * rotate the half extents around that same center and take the box that
+ * encloses the result. For rotation = 0 this is exactly the dstRect.
+*/
+inline AABB ComputeSpriteBounds(const TransformComponent& transform, double width, double height) {
+    const float halfWidth = static_cast<float>(std::fabs(width * transform.scale.x) * 0.5);
+    const float halfHeight = static_cast<float>(std::fabs(height * transform.scale.y) * 0.5);
+    const float centerX = transform.position.x + static_cast<float>(width * transform.scale.x * 0.5);
+    const float centerY = transform.position.y + static_cast<float>(height * transform.scale.y * 0.5);
+
+    const float radians = static_cast<float>(glm::radians(transform.rotation));
+    const float c = std::fabs(std::cos(radians));
+    const float s = std::fabs(std::sin(radians));
+
+    const float extentX = halfWidth * c + halfHeight * s;
+    const float extentY = halfWidth * s + halfHeight * c;
+
+    return { centerX - extentX, centerY - extentY, centerX + extentX, centerY + extentY };
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef OBB_H
+#define OBB_H
+
+#include <cmath>
+#include <glm/glm.hpp>
+#include "../Components/TransformComponent.h"
+#include "../Components/BoxColliderComponent.h"
+#include "./AABB.h"
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// OBB ////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Oriented bounding box: a center, the half size along its own axes and the
+// rotation stored as cos/sin so the narrowphase never calls trig functions.
+// The local x axis is (cosine, sine) and the local y axis (-sine, cosine),
+// which with y pointing down matches the clockwise degrees SDL uses.
+////////////////////////////////////////////////////////////////////////////
+struct OBB {
+    float centerX = 0;
+    float centerY = 0;
+    float halfWidth = 0;
+    float halfHeight = 0;
+    float cosine = 1;
+    float sine = 0;
+
+    AABB GetBounds() const {
+        const float c = std::fabs(cosine);
+        const float s = std::fabs(sine);
+        const float extentX = halfWidth * c + halfHeight * s;
+        const float extentY = halfWidth * s + halfHeight * c;
+        return { centerX - extentX, centerY - extentY, centerX + extentX, centerY + extentY };
+    }
+};
+
+/**
+ * The collider box turns with its sprite. SDL_RenderCopyEx rotates around the center of the
+ * dstRect, so the center of the box is rotated around that same point, half the scaled
+ * sprite size from the position.
+*/
+inline OBB ComputeColliderOBB(const TransformComponent& transform, const BoxColliderComponent& collider, double spriteWidth, double spriteHeight) {
+    const float width = collider.width * transform.scale.x;
+    const float height = collider.height * transform.scale.y;
+    const float radians = static_cast<float>(glm::radians(transform.rotation));
+    const float c = std::cos(radians);
+    const float s = std::sin(radians);
+
+    const float pivotX = transform.position.x + static_cast<float>(spriteWidth * transform.scale.x * 0.5);
+    const float pivotY = transform.position.y + static_cast<float>(spriteHeight * transform.scale.y * 0.5);
+    const float offsetX = transform.position.x + collider.offset.x * transform.scale.x + width * 0.5f - pivotX;
+    const float offsetY = transform.position.y + collider.offset.y * transform.scale.y + height * 0.5f - pivotY;
+
+    OBB box;
+    box.centerX = pivotX + offsetX * c - offsetY * s;
+    box.centerY = pivotY + offsetX * s + offsetY * c;
+    box.halfWidth = std::fabs(width) * 0.5f;
+    box.halfHeight = std::fabs(height) * 0.5f;
+    box.cosine = c;
+    box.sine = s;
+    return box;
+}
+
+/**
+ * Without a sprite there is nothing to line up with, the box rotates around its own center
+*/
+inline OBB ComputeColliderOBB(const TransformComponent& transform, const BoxColliderComponent& collider) {
+    return ComputeColliderOBB(
+        transform,
+        collider,
+        collider.offset.x * 2.0 + collider.width,
+        collider.offset.y * 2.0 + collider.height
+    );
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "./OBBNarrowphase.h"
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Reference version of the test, also used for the pairs that don't fill a SIMD batch.
+ * With d = centerB - centerA and C, S the cos/sin of the relative rotation:
+ *   axis uA: rA = hwA, rB = hwB*|C| + hhB*|S|
+ *   axis vA: rA = hhA, rB = hwB*|S| + hhB*|C|
+ *   axis uB: rB = hwB, rA = hwA*|C| + hhA*|S|
+ *   axis vB: rB = hhB, rA = hwA*|S| + hhA*|C|
+ * and the overlap on each axis is rA + rB - |d . axis|.
+*/
+static void TestOBBPair(const OBB& a, const OBB& b, OBBContact& contact) {
+    const float dx = b.centerX - a.centerX;
+    const float dy = b.centerY - a.centerY;
+
+    const float absC = std::fabs(a.cosine * b.cosine + a.sine * b.sine);
+    const float absS = std::fabs(a.cosine * b.sine - a.sine * b.cosine);
+
+    const float axesX[4] = { a.cosine, -a.sine, b.cosine, -b.sine };
+    const float axesY[4] = { a.sine, a.cosine, b.sine, b.cosine };
+    const float radii[4] = {
+        a.halfWidth + b.halfWidth * absC + b.halfHeight * absS,
+        a.halfHeight + b.halfWidth * absS + b.halfHeight * absC,
+        b.halfWidth + a.halfWidth * absC + a.halfHeight * absS,
+        b.halfHeight + a.halfWidth * absS + a.halfHeight * absC
+    };
+
+    contact.hit = true;
+    contact.depth = INFINITY;
+    for (int axis = 0; axis < 4; axis++) {
+        const float distance = dx * axesX[axis] + dy * axesY[axis];
+        const float overlap = radii[axis] - std::fabs(distance);
+
+        if (overlap < 0) {
+            contact.hit = false;
+            return;
+        }
+
+        if (overlap < contact.depth) {
+            const float sign = distance < 0 ? -1.0f : 1.0f;
+            contact.depth = overlap;
+            contact.normalX = axesX[axis] * sign;
+            contact.normalY = axesY[axis] * sign;
+        }
+    }
+}
+
+#if defined(__SSE2__)
+
+static inline __m128 Abs(__m128 value) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+}
+
+// mask ? a : b (SSE2 has no blend instruction)
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static void TestOBBQuad(const OBB* a, const OBB* b, OBBContact* contacts) {
+    // Transpose 4 pairs into SoA lanes
+    const __m128 aX  = _mm_setr_ps(a[0].centerX, a[1].centerX, a[2].centerX, a[3].centerX);
+    const __m128 aY  = _mm_setr_ps(a[0].centerY, a[1].centerY, a[2].centerY, a[3].centerY);
+    const __m128 aHW = _mm_setr_ps(a[0].halfWidth, a[1].halfWidth, a[2].halfWidth, a[3].halfWidth);
+    const __m128 aHH = _mm_setr_ps(a[0].halfHeight, a[1].halfHeight, a[2].halfHeight, a[3].halfHeight);
+    const __m128 aC  = _mm_setr_ps(a[0].cosine, a[1].cosine, a[2].cosine, a[3].cosine);
+    const __m128 aS  = _mm_setr_ps(a[0].sine, a[1].sine, a[2].sine, a[3].sine);
+
+    const __m128 bX  = _mm_setr_ps(b[0].centerX, b[1].centerX, b[2].centerX, b[3].centerX);
+    const __m128 bY  = _mm_setr_ps(b[0].centerY, b[1].centerY, b[2].centerY, b[3].centerY);
+    const __m128 bHW = _mm_setr_ps(b[0].halfWidth, b[1].halfWidth, b[2].halfWidth, b[3].halfWidth);
+    const __m128 bHH = _mm_setr_ps(b[0].halfHeight, b[1].halfHeight, b[2].halfHeight, b[3].halfHeight);
+    const __m128 bC  = _mm_setr_ps(b[0].cosine, b[1].cosine, b[2].cosine, b[3].cosine);
+    const __m128 bS  = _mm_setr_ps(b[0].sine, b[1].sine, b[2].sine, b[3].sine);
+
+    const __m128 dx = _mm_sub_ps(bX, aX);
+    const __m128 dy = _mm_sub_ps(bY, aY);
+
+    const __m128 absC = Abs(_mm_add_ps(_mm_mul_ps(aC, bC), _mm_mul_ps(aS, bS)));
+    const __m128 absS = Abs(_mm_sub_ps(_mm_mul_ps(aC, bS), _mm_mul_ps(aS, bC)));
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    const __m128 axesX[4] = { aC, _mm_xor_ps(aS, signBit), bC, _mm_xor_ps(bS, signBit) };
+    const __m128 axesY[4] = { aS, aC, bS, bC };
+    const __m128 radii[4] = {
+        _mm_add_ps(aHW, _mm_add_ps(_mm_mul_ps(bHW, absC), _mm_mul_ps(bHH, absS))),
+        _mm_add_ps(aHH, _mm_add_ps(_mm_mul_ps(bHW, absS), _mm_mul_ps(bHH, absC))),
+        _mm_add_ps(bHW, _mm_add_ps(_mm_mul_ps(aHW, absC), _mm_mul_ps(aHH, absS))),
+        _mm_add_ps(bHH, _mm_add_ps(_mm_mul_ps(aHW, absS), _mm_mul_ps(aHH, absC)))
+    };
+
+    __m128 separated = _mm_setzero_ps();
+    __m128 depth = _mm_set1_ps(INFINITY);
+    __m128 normalX = zero;
+    __m128 normalY = zero;
+
+    for (int axis = 0; axis < 4; axis++) {
+        const __m128 distance = _mm_add_ps(_mm_mul_ps(dx, axesX[axis]), _mm_mul_ps(dy, axesY[axis]));
+        const __m128 overlap = _mm_sub_ps(radii[axis], Abs(distance));
+
+        separated = _mm_or_ps(separated, _mm_cmplt_ps(overlap, zero));
+
+        // Flip the axis so that it points from a to b
+        const __m128 sign = _mm_and_ps(_mm_cmplt_ps(distance, zero), signBit);
+        const __m128 better = _mm_cmplt_ps(overlap, depth);
+        depth = Select(better, overlap, depth);
+        normalX = Select(better, _mm_xor_ps(axesX[axis], sign), normalX);
+        normalY = Select(better, _mm_xor_ps(axesY[axis], sign), normalY);
+    }
+
+    alignas(16) float depths[4];
+    alignas(16) float normalsX[4];
+    alignas(16) float normalsY[4];
+    _mm_store_ps(depths, depth);
+    _mm_store_ps(normalsX, normalX);
+    _mm_store_ps(normalsY, normalY);
+    const int separatedMask = _mm_movemask_ps(separated);
+
+    for (int lane = 0; lane < 4; lane++) {
+        OBBContact& contact = contacts[lane];
+        contact.hit = (separatedMask & (1 << lane)) == 0;
+        contact.depth = depths[lane];
+        contact.normalX = normalsX[lane];
+        contact.normalY = normalsY[lane];
+    }
+}
+
+#endif
+
+void TestOBBPairs(const OBB* first, const OBB* second, int count, OBBContact* contacts) {
+    int i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        TestOBBQuad(first + i, second + i, contacts + i);
+    }
+#endif
+
+    for (; i < count; i++) {
+        TestOBBPair(first[i], second[i], contacts[i]);
+    }
+}
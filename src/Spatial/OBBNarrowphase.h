@@ -0,0 +1,28 @@
+#ifndef OBBNARROWPHASE_H
+#define OBBNARROWPHASE_H
+
+#include "./OBB.h"
+
+struct OBBContact {
+    bool hit = false;
+    // Separation axis with the smallest overlap, pointing from the first box to the second
+    float normalX = 0;
+    float normalY = 0;
+    float depth = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// OBB Narrowphase ////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Separating axis test between pairs of oriented boxes: first[i] vs second[i]
+// for i in [0, count), result written to contacts[i].
+//
+// Two 2D boxes only have 4 candidate axes (the two local axes of each box),
+// and the projections reduce to the cos/sin of the relative rotation, so a
+// pair costs a handful of multiply-adds. Pairs are processed 4 at a time in
+// SSE lanes, the remainder (or the whole batch without SSE2) goes through
+// the same math one pair at a time.
+////////////////////////////////////////////////////////////////////////////
+void TestOBBPairs(const OBB* first, const OBB* second, int count, OBBContact* contacts);
+
+#endif
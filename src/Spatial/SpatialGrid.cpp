@@ -0,0 +1,242 @@
+#include "./SpatialGrid.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <cmath>
+
+// Cell coordinates are clamped to this, so huge or broken bounds still give an int
+const double SPATIAL_GRID_MAX_CELL = 1 << 24;
+
+SpatialGrid::SpatialGrid(float cellSize, int bucketCount) {
+    this->cellSize = cellSize > 0 ? cellSize : 64.0f;
+
+    // Round the bucket count up to a power of two so the hash can be masked
+    uint32_t count = 1;
+    while (count < static_cast<uint32_t>(std::max(bucketCount, 1))) {
+        count <<= 1;
+    }
+    bucketMask = count - 1;
+    buckets.resize(count);
+
+    Logger::Success("SpatialGrid constructor called!");
+}
+
+SpatialGrid::~SpatialGrid() {
+    Logger::Success("SpatialGrid destructor called!");
+}
+
+float SpatialGrid::GetCellSize() const {
+    return cellSize;
+}
+
+int SpatialGrid::CellCoord(float value) const {
+    const double cell = std::floor(static_cast<double>(value) / cellSize);
+    if (!(cell > -SPATIAL_GRID_MAX_CELL)) {
+        return static_cast<int>(-SPATIAL_GRID_MAX_CELL);
+    }
+    return static_cast<int>(std::min(cell, SPATIAL_GRID_MAX_CELL));
+}
+
+/**
+ * Classic "large primes xor" spatial hash. Different cells can land on the
+ * same bucket, which is fine: queries always test the real bounds afterwards.
+*/
+uint32_t SpatialGrid::BucketIndex(int cellX, int cellY) const {
+    const uint32_t hash = (static_cast<uint32_t>(cellX) * 73856093u) ^ (static_cast<uint32_t>(cellY) * 19349663u);
+    return hash & bucketMask;
+}
+
+bool SpatialGrid::IsOversized(const Proxy& proxy) const {
+    const double cellCount = (static_cast<double>(proxy.maxCellX) - proxy.minCellX + 1) * (static_cast<double>(proxy.maxCellY) - proxy.minCellY + 1);
+    return cellCount >= static_cast<double>(buckets.size());
+}
+
+void SpatialGrid::AddToCells(int entityId, const Proxy& proxy) {
+    if (IsOversized(proxy)) {
+        oversized.push_back(entityId);
+        return;
+    }
+    for (int y = proxy.minCellY; y <= proxy.maxCellY; y++) {
+        for (int x = proxy.minCellX; x <= proxy.maxCellX; x++) {
+            buckets[BucketIndex(x, y)].push_back(entityId);
+        }
+    }
+}
+
+void SpatialGrid::RemoveFromCells(int entityId, const Proxy& proxy) {
+    if (IsOversized(proxy)) {
+        oversized.erase(std::find(oversized.begin(), oversized.end(), entityId));
+        return;
+    }
+    for (int y = proxy.minCellY; y <= proxy.maxCellY; y++) {
+        for (int x = proxy.minCellX; x <= proxy.maxCellX; x++) {
+            std::vector<int>& bucket = buckets[BucketIndex(x, y)];
+            // Buckets are small and unordered, so swap with the last one and pop
+            auto it = std::find(bucket.begin(), bucket.end(), entityId);
+            if (it != bucket.end()) {
+                *it = bucket.back();
+                bucket.pop_back();
+            }
+        }
+    }
+}
+
+/**
+ * Inserts the entity or moves it to its new bounds. Buckets are only
+ * touched when the range of covered cells actually changes.
+*/
+void SpatialGrid::Update(Entity entity, const AABB& bounds) {
+    const int entityId = entity.GetId();
+    if (entityId < 0) {
+        return;
+    }
+
+    if (entityId >= static_cast<int>(proxies.size())) {
+        proxies.resize(entityId + 1);
+        queryStamps.resize(entityId + 1, 0);
+    }
+
+    Proxy& proxy = proxies[entityId];
+    const int minCellX = CellCoord(bounds.minX);
+    const int minCellY = CellCoord(bounds.minY);
+    const int maxCellX = CellCoord(bounds.maxX);
+    const int maxCellY = CellCoord(bounds.maxY);
+
+    const bool sameCells = proxy.active &&
+        proxy.minCellX == minCellX && proxy.minCellY == minCellY &&
+        proxy.maxCellX == maxCellX && proxy.maxCellY == maxCellY;
+
+    proxy.entity = entity;
+    proxy.bounds = bounds;
+
+    if (sameCells) {
+        return;
+    }
+
+    if (proxy.active) {
+        RemoveFromCells(entityId, proxy);
+    }
+
+    proxy.minCellX = minCellX;
+    proxy.minCellY = minCellY;
+    proxy.maxCellX = maxCellX;
+    proxy.maxCellY = maxCellY;
+    proxy.active = true;
+
+    AddToCells(entityId, proxy);
+}
+
+void SpatialGrid::Remove(Entity entity) {
+    const int entityId = entity.GetId();
+    if (!Contains(entity)) {
+        return;
+    }
+
+    Proxy& proxy = proxies[entityId];
+    RemoveFromCells(entityId, proxy);
+    proxy.active = false;
+}
+
+bool SpatialGrid::Contains(Entity entity) const {
+    const int entityId = entity.GetId();
+    return entityId >= 0 && entityId < static_cast<int>(proxies.size()) && proxies[entityId].active;
+}
+
+/**
+ * Drops every entity but keeps the memory of the buckets around
+*/
+void SpatialGrid::Clear() {
+    for (auto& bucket: buckets) {
+        bucket.clear();
+    }
+    oversized.clear();
+    for (auto& proxy: proxies) {
+        proxy.active = false;
+    }
+}
+
+void SpatialGrid::NextStamp() {
+    currentStamp++;
+
+    // On wrap around old stamps could match again, so start over from a clean slate
+    if (currentStamp == 0) {
+        std::fill(queryStamps.begin(), queryStamps.end(), 0);
+        currentStamp = 1;
+    }
+}
+
+void SpatialGrid::Collect(int entityId, const AABB& area, std::vector<Entity>& results) {
+    if (queryStamps[entityId] == currentStamp) {
+        return;
+    }
+    queryStamps[entityId] = currentStamp;
+
+    const Proxy& proxy = proxies[entityId];
+    if (proxy.bounds.Intersects(area)) {
+        results.push_back(proxy.entity);
+    }
+}
+
+/**
+ * Fills `results` with every entity whose bounds overlap `area`.
+ * The vector is cleared first, its capacity is kept.
+*/
+int SpatialGrid::QueryRect(const AABB& area, std::vector<Entity>& results) {
+    results.clear();
+    NextStamp();
+
+    const int minCellX = CellCoord(area.minX);
+    const int minCellY = CellCoord(area.minY);
+    const int maxCellX = CellCoord(area.maxX);
+    const int maxCellY = CellCoord(area.maxY);
+
+    for (int entityId: oversized) {
+        Collect(entityId, area, results);
+    }
+
+    // If the area covers more cells than there are buckets, every bucket would
+    // be visited at least once anyway, so just walk the buckets directly.
+    const double cellCount = (static_cast<double>(maxCellX) - minCellX + 1) * (static_cast<double>(maxCellY) - minCellY + 1);
+    if (cellCount >= static_cast<double>(buckets.size())) {
+        for (const auto& bucket: buckets) {
+            for (int entityId: bucket) {
+                Collect(entityId, area, results);
+            }
+        }
+        return static_cast<int>(results.size());
+    }
+
+    for (int y = minCellY; y <= maxCellY; y++) {
+        for (int x = minCellX; x <= maxCellX; x++) {
+            for (int entityId: buckets[BucketIndex(x, y)]) {
+                Collect(entityId, area, results);
+            }
+        }
+    }
+
+    return static_cast<int>(results.size());
+}
+
+/**
+ * Fills `results` with every entity whose bounds touch the circle.
+*/
+int SpatialGrid::QueryRadius(const glm::vec2& center, float radius, std::vector<Entity>& results) {
+    const AABB area = { center.x - radius, center.y - radius, center.x + radius, center.y + radius };
+    QueryRect(area, results);
+
+    // Narrow the square down to the circle, compacting in place
+    const float radiusSquared = radius * radius;
+    size_t kept = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        const AABB& bounds = proxies[results[i].GetId()].bounds;
+        const float closestX = std::clamp(center.x, bounds.minX, bounds.maxX);
+        const float closestY = std::clamp(center.y, bounds.minY, bounds.maxY);
+        const float dx = center.x - closestX;
+        const float dy = center.y - closestY;
+        if (dx * dx + dy * dy <= radiusSquared) {
+            results[kept++] = results[i];
+        }
+    }
+    results.erase(results.begin() + kept, results.end());
+
+    return static_cast<int>(results.size());
+}
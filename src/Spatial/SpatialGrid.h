@@ -0,0 +1,76 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "../ECS/ECS.h"
+#include "./AABB.h"
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Spatial Grid ///////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Uniform grid of square cells hashed into a fixed number of buckets, so the
+// world doesn't need to have known bounds. Every entity remembers the range
+// of cells it covers; as long as it moves inside that range only its bounds
+// get updated, and buckets are only touched when it crosses a cell border.
+//
+// An entity covering more cells than there are buckets would land in every
+// bucket anyway, so it goes in a short list of oversized entities that every
+// query checks instead of being added cell by cell.
+//
+// Queries write into a caller owned vector that is cleared but never shrunk,
+// so once a system's buffer is warm, queries don't allocate.
+////////////////////////////////////////////////////////////////////////////
+class SpatialGrid {
+    private:
+        struct Proxy {
+            Entity entity = Entity(-1);
+            AABB bounds;
+            int minCellX = 0;
+            int minCellY = 0;
+            int maxCellX = -1;
+            int maxCellY = -1;
+            bool active = false;
+        };
+
+        float cellSize;
+        uint32_t bucketMask;
+
+        // [bucket => entity ids whose cells hash into the bucket]
+        std::vector<std::vector<int>> buckets;
+        // Entities too big to add cell by cell, checked by every query
+        std::vector<int> oversized;
+        // [entityId => Proxy]
+        std::vector<Proxy> proxies;
+
+        // Used to report each entity only once per query even if it spans many cells
+        std::vector<uint32_t> queryStamps;
+        uint32_t currentStamp = 0;
+
+        int CellCoord(float value) const;
+        uint32_t BucketIndex(int cellX, int cellY) const;
+        bool IsOversized(const Proxy& proxy) const;
+        void AddToCells(int entityId, const Proxy& proxy);
+        void RemoveFromCells(int entityId, const Proxy& proxy);
+        void NextStamp();
+        void Collect(int entityId, const AABB& area, std::vector<Entity>& results);
+
+    public:
+        SpatialGrid(float cellSize = 64.0f, int bucketCount = 4096);
+        ~SpatialGrid();
+
+        //////// Maintenance ////////
+        void Update(Entity entity, const AABB& bounds);
+        void Remove(Entity entity);
+        void Clear();
+        bool Contains(Entity entity) const;
+
+        //////// Queries ////////
+        int QueryRect(const AABB& area, std::vector<Entity>& results);
+        int QueryRadius(const glm::vec2& center, float radius, std::vector<Entity>& results);
+
+        float GetCellSize() const;
+};
+
+#endif
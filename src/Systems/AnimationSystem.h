@@ -0,0 +1,71 @@
+#ifndef ANIMATIONSYSTEM_H
+#define ANIMATIONSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Animation/AnimationLibrary.h"
+#include "../Components/SpriteComponent.h"
+#include "../Components/AnimationComponent.h"
+
+#include <algorithm>
+
+class AnimationSystem : public System {
+    private:
+        // Advanced by the frame delta time rather than read from SDL_GetTicks, so animations
+        // pause with the game and play the same way every time for the same frame times
+        double clockMs = 0;
+
+    public:
+        AnimationSystem() {
+            RequireComponent<SpriteComponent>();
+            RequireComponent<AnimationComponent>();
+        }
+
+        // The clock is part of the simulation, the Game puts it back when it rolls back
+        double GetClockMs() const {
+            return clockMs;
+        }
+
+        void SetClockMs(double ms) {
+            clockMs = ms;
+        }
+
+        /**
+         * Works out the current frame of every animated entity from the time since its clip
+         * started. The sprite is only touched when the frame actually changes.
+        */
+        void Update(double deltaTime, const std::unique_ptr<AnimationLibrary>& animationLibrary) {
+            clockMs += deltaTime * 1000.0;
+            const int now = static_cast<int>(clockMs);
+
+            const AnimationClip* clips = animationLibrary->GetClips().data();
+            const SDL_Rect* frames = animationLibrary->GetFrames().data();
+            const int clipCount = static_cast<int>(animationLibrary->GetClips().size());
+
+            for (Entity entity: GetSystemEntities()) {
+                // Only taken for writing when the frame changes, most frames don't (see Registry::Rollback)
+                const AnimationComponent& current = entity.ReadComponent<AnimationComponent>();
+                if (current.clipId < 0 || current.clipId >= clipCount) {
+                    continue;
+                }
+
+                // A new clip, or a restart, plays from its first frame
+                if (current.startTimeMs < 0 || current.playingClipId != current.clipId) {
+                    AnimationComponent& animation = entity.GetComponent<AnimationComponent>();
+                    animation.playingClipId = animation.clipId;
+                    animation.startTimeMs = now;
+                    animation.frameIndex = -1;
+                }
+
+                const AnimationClip& clip = clips[current.clipId];
+                int frame = (now - current.startTimeMs) / clip.frameDurationMs;
+                frame = clip.loop ? frame % clip.frameCount : std::min(frame, clip.frameCount - 1);
+
+                if (frame != current.frameIndex) {
+                    entity.GetComponent<AnimationComponent>().frameIndex = frame;
+                    entity.GetComponent<SpriteComponent>().srcRect = frames[clip.firstFrame + frame];
+                }
+            }
+        }
+};
+
+#endif
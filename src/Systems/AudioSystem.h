@@ -0,0 +1,236 @@
+#ifndef AUDIOSYSTEM_H
+#define AUDIOSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../AssetStore/AssetStore.h"
+#include "../Audio/AudioThread.h"
+#include "../Camera/Camera.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/AudioSourceComponent.h"
+
+#include <SDL2/SDL_mixer.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Mixer channels the AudioSystem plays through, any source beyond that is virtual
+const int AUDIO_MAX_VOICES = 16;
+// A one shot that lost its channel can only get one back this soon after it started,
+// after that it would be heard starting late so it stays virtual until it's over
+const int AUDIO_ONE_SHOT_RESUME_MS = 100;
+
+/**
+ * Plays every AudioSourceComponent relative to a listener at the center of the camera.
+ *
+ * All emitters go through one batched pass that works out their gain and panning. Only the
+ * AUDIO_MAX_VOICES best ones (by priority, then gain) get a real mixer channel, the rest are
+ * virtual and cost nothing but that pass. Channels are handed out by the system itself and
+ * a request is only sent when a voice starts, stops or its volume/panning changes.
+ *
+ * The system never calls the mixer directly, every request goes through the AudioThread queue.
+ *
+ * Whether a source is still playing, its channel and when it started are kept here by entity
+ * and never written to the Registry. What is heard depends on the audio device, so it must not
+ * change the checksum, the rollback history or a replay.
+*/
+class AudioSystem : public System {
+    private:
+        struct Voice {
+            Entity entity;
+            Mix_Chunk* chunk;
+            float gain;
+            float pan;
+            int priority;
+        };
+
+        // Reset when the entity gets a new AudioSourceComponent
+        struct Playback {
+            bool finished = false;
+            int channel = -1;
+            int startTimeMs = -1;
+        };
+
+        struct Channel {
+            int owner = -1;
+            int volume = -1;
+            Uint8 left = 0;
+            Uint8 right = 0;
+            bool kept = false;
+        };
+
+        // Audible emitters of the current frame, reused
+        std::vector<Voice> voices;
+        std::vector<Channel> channels;
+        // [entityId => playback of its source]
+        std::vector<Playback> playbacks;
+
+        // Only follows the frames that were played, rollback doesn't take it back: audio
+        // is presentation and what was heard can't be unheard
+        double clockMs = 0;
+
+        int FindFreeChannel() const {
+            for (int channel = 0; channel < static_cast<int>(channels.size()); channel++) {
+                if (channels[channel].owner < 0) {
+                    return channel;
+                }
+            }
+            return -1;
+        }
+
+        Playback& GetPlayback(Entity entity) {
+            if (entity.GetId() >= static_cast<int>(playbacks.size())) {
+                playbacks.resize(entity.GetId() + 1);
+            }
+            return playbacks[entity.GetId()];
+        }
+
+    public:
+        AudioSystem() {
+            RequireComponent<TransformComponent>();
+            RequireComponent<AudioSourceComponent>();
+            channels.resize(AUDIO_MAX_VOICES);
+        }
+
+        void SubscribeToRegistry(std::unique_ptr<Registry>& registry) {
+            registry->OnAdd<AudioSourceComponent, AudioSystem, &AudioSystem::OnSourcesAdded>(this);
+        }
+
+        // A new source starts from the beginning, even on an entity id that played one before
+        void OnSourcesAdded(const std::vector<Entity>& entities) {
+            for (Entity entity: entities) {
+                GetPlayback(entity) = Playback();
+            }
+        }
+
+        void Update(double deltaTime, const Camera& camera, std::unique_ptr<AssetStore>& assetStore, std::unique_ptr<AudioThread>& audioThread) {
+            clockMs += deltaTime * 1000.0;
+            const int now = static_cast<int>(clockMs);
+            const int bytesPerMs = audioThread->GetBytesPerMs();
+
+            const glm::vec2 listener = camera.position + camera.GetViewSize() * 0.5f;
+
+            // 1. Batched pass: gain and panning of every emitter, virtual or not
+            voices.clear();
+            for (Entity entity: GetSystemEntities()) {
+                const AudioSourceComponent& source = entity.ReadComponent<AudioSourceComponent>();
+                Playback& playback = GetPlayback(entity);
+                if (playback.finished) {
+                    continue;
+                }
+
+                Mix_Chunk* chunk = assetStore->GetSound(source.soundId);
+                if (!chunk) {
+                    continue;
+                }
+
+                if (playback.startTimeMs < 0) {
+                    playback.startTimeMs = now;
+                }
+
+                // One shots end on time whether they were heard or not
+                if (!source.loop && bytesPerMs > 0 && now - playback.startTimeMs >= static_cast<int>(chunk->alen) / bytesPerMs) {
+                    playback.finished = true;
+                    continue;
+                }
+
+                const TransformComponent& transform = entity.ReadComponent<TransformComponent>();
+                const glm::vec2 offset = transform.position - listener;
+                const float distance = glm::length(offset);
+                const float gain = source.volume * (1.0f - distance / std::max(source.range, 1.0f));
+                if (gain <= 0.0f) {
+                    continue;
+                }
+
+                const float pan = std::clamp(offset.x / std::max(source.range, 1.0f), -1.0f, 1.0f);
+                voices.push_back({entity, chunk, std::min(gain, 1.0f), pan, source.priority});
+            }
+
+            // 2. Only the best voices get a channel
+            const size_t realVoices = std::min(voices.size(), static_cast<size_t>(AUDIO_MAX_VOICES));
+            if (voices.size() > realVoices) {
+                std::nth_element(voices.begin(), voices.begin() + realVoices, voices.end(), [](const Voice& a, const Voice& b) {
+                    return a.priority != b.priority ? a.priority > b.priority : a.gain > b.gain;
+                });
+            }
+
+            for (auto& channel: channels) {
+                channel.kept = false;
+            }
+
+            for (size_t i = 0; i < realVoices; i++) {
+                const Voice& voice = voices[i];
+                const AudioSourceComponent& source = voice.entity.ReadComponent<AudioSourceComponent>();
+                Playback& playback = playbacks[voice.entity.GetId()];
+                const int entityId = voice.entity.GetId();
+
+                const bool hasChannel = playback.channel >= 0 && channels[playback.channel].owner == entityId;
+                if (!hasChannel) {
+                    playback.channel = -1;
+                    if (!source.loop && now - playback.startTimeMs > AUDIO_ONE_SHOT_RESUME_MS) {
+                        continue;
+                    }
+
+                    const int channel = FindFreeChannel();
+                    if (channel < 0) {
+                        continue;
+                    }
+                    audioThread->PlayChannel(channel, voice.chunk, source.loop ? -1 : 0);
+                    channels[channel] = Channel();
+                    channels[channel].owner = entityId;
+                    playback.channel = channel;
+                }
+
+                Channel& channel = channels[playback.channel];
+                channel.kept = true;
+
+                const int volume = static_cast<int>(voice.gain * MIX_MAX_VOLUME);
+                if (volume != channel.volume) {
+                    audioThread->SetVolume(playback.channel, volume);
+                    channel.volume = volume;
+                }
+
+                // Constant power panning
+                const float angle = (voice.pan + 1.0f) * 0.25f * static_cast<float>(M_PI);
+                const Uint8 left = static_cast<Uint8>(255.0f * std::cos(angle));
+                const Uint8 right = static_cast<Uint8>(255.0f * std::sin(angle));
+                if (left != channel.left || right != channel.right) {
+                    audioThread->SetPanning(playback.channel, left, right);
+                    channel.left = left;
+                    channel.right = right;
+                }
+            }
+
+            // 3. Virtualize everything that didn't make it (or is gone, or went silent)
+            for (int channel = 0; channel < static_cast<int>(channels.size()); channel++) {
+                if (channels[channel].owner >= 0 && !channels[channel].kept) {
+                    audioThread->HaltChannel(channel);
+                    channels[channel] = Channel();
+                }
+            }
+        }
+
+        /**
+         * Silences every voice, for when the entities are replaced all at once (a snapshot
+         * load). Every source starts over.
+        */
+        void Reset(std::unique_ptr<AudioThread>& audioThread) {
+            audioThread->HaltAll();
+            for (auto& channel: channels) {
+                channel = Channel();
+            }
+            playbacks.clear();
+        }
+
+        /**
+         * Silences every voice and the music, sources keep their state
+        */
+        void StopAll(std::unique_ptr<AudioThread>& audioThread) {
+            audioThread->HaltAll();
+            audioThread->StopMusic();
+            for (auto& channel: channels) {
+                channel = Channel();
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef CAMERASYSTEM_H
+#define CAMERASYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Camera/Camera.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../Components/CameraComponent.h"
+#include "../EventBus/EventBus.h"
+#include "../Events/KeyPressedEvent.h"
+
+#include <algorithm>
+
+class CameraSystem : public System {
+    public:
+        CameraSystem() {
+            RequireComponent<CameraComponent>();
+            RequireComponent<TransformComponent>();
+        }
+
+        void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus) {
+            eventBus->Subscribe<KeyPressedEvent, CameraSystem, &CameraSystem::OnKeyPressed>(this, EVENT_PHASE_PRE_UPDATE);
+        }
+
+        // Zoom in/out with the +/- keys
+        void OnKeyPressed(const KeyPressedEvent& event) {
+            if (event.symbol == SDLK_EQUALS) {
+                Zoom(1.25f);
+            } else if (event.symbol == SDLK_MINUS) {
+                Zoom(0.8f);
+            }
+        }
+
+        /**
+         * Centers the camera on the entity that carries the CameraComponent and applies its zoom.
+         * The view is kept inside the world bounds, unless the world is smaller than the view.
+        */
+        void Update(Camera& camera, const SDL_Rect& worldBounds) {
+            for (Entity entity: GetSystemEntities()) {
+                CameraComponent& cameraComponent = entity.GetComponent<CameraComponent>();
+                const TransformComponent& transform = entity.ReadComponent<TransformComponent>();
+
+                cameraComponent.zoom = std::clamp(cameraComponent.zoom, cameraComponent.minZoom, cameraComponent.maxZoom);
+                camera.zoom = cameraComponent.zoom;
+
+                glm::vec2 target = transform.position;
+                if (entity.HasComponent<SpriteComponent>()) {
+                    const SpriteComponent& sprite = entity.ReadComponent<SpriteComponent>();
+                    target += glm::vec2(sprite.width * transform.scale.x, sprite.height * transform.scale.y) * 0.5f;
+                }
+
+                const glm::vec2 viewSize = camera.GetViewSize();
+                camera.position = target - viewSize * 0.5f;
+
+                const glm::vec2 worldMin(worldBounds.x, worldBounds.y);
+                const glm::vec2 worldMax = worldMin + glm::vec2(worldBounds.w, worldBounds.h) - viewSize;
+                camera.position.x = worldMax.x >= worldMin.x ? std::clamp(camera.position.x, worldMin.x, worldMax.x) : worldMin.x;
+                camera.position.y = worldMax.y >= worldMin.y ? std::clamp(camera.position.y, worldMin.y, worldMax.y) : worldMin.y;
+
+                // There is only one camera, the first entity wins
+                break;
+            }
+        }
+
+        /**
+         * Multiplies the zoom of the camera, it gets clamped on the next Update
+        */
+        void Zoom(float factor) {
+            for (Entity entity: GetSystemEntities()) {
+                entity.GetComponent<CameraComponent>().zoom *= factor;
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef COLLISIONSYSTEM_H
+#define COLLISIONSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/BoxColliderComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../Spatial/AABB.h"
+#include "../Spatial/OBB.h"
+#include "../Spatial/OBBNarrowphase.h"
+#include "../EventBus/EventBus.h"
+#include "../Events/CollisionEvent.h"
+
+#include <vector>
+#include <algorithm>
+
+struct CollisionPair {
+    Entity a;
+    Entity b;
+    // Pushing b along the normal by depth separates the two boxes
+    glm::vec2 normal;
+    float depth;
+};
+
+/**
+ * Finds every pair of overlapping box colliders.
+ *
+ * Broadphase is sort-and-sweep on the x axis. The proxies stay sorted between frames
+ * and are re-sorted with an insertion sort, which is close to O(n) because entities
+ * barely move from one frame to the next. The sweep then only pairs up boxes whose
+ * x intervals overlap and drops the ones whose y intervals don't.
+ *
+ * The candidates that survive are the bounding boxes of rotated colliders, so the
+ * narrowphase runs an oriented box separating axis test on them in SIMD batches
+ * (see TestOBBPairs), which also gives the contact normal and penetration depth.
+ *
+ * Results go into a vector that is reused every frame, read them with GetCollisions(),
+ * and every one of them is emitted as a CollisionEvent.
+ *
+ * Which entities have a proxy is kept up to date by the Registry observers: a collider
+ * or a transform being added or taken off adds or drops the proxy when it happens.
+*/
+class CollisionSystem : public System {
+    private:
+        struct Proxy {
+            Entity entity;
+            OBB box;
+            AABB bounds;
+        };
+
+        // Sorted on bounds.minX, kept from one frame to the next
+        std::vector<Proxy> proxies;
+        // [entityId => whether the entity has a proxy]
+        std::vector<uint8_t> hasProxy;
+
+        // Broadphase output and narrowphase batch, reused every frame
+        std::vector<std::pair<int, int>> candidates;
+        std::vector<OBB> firstBoxes;
+        std::vector<OBB> secondBoxes;
+        std::vector<OBBContact> contacts;
+
+        std::vector<CollisionPair> collisions;
+
+        // Appends a proxy for the ones that have a collider and a transform, the sort puts it in place
+        void AddProxies(const std::vector<Entity>& entities) {
+            for (Entity entity: entities) {
+                if (!entity.HasComponent<TransformComponent>() || !entity.HasComponent<BoxColliderComponent>()) {
+                    continue;
+                }
+                const int entityId = entity.GetId();
+                if (entityId >= static_cast<int>(hasProxy.size())) {
+                    hasProxy.resize(entityId + 1, 0);
+                }
+                if (!hasProxy[entityId]) {
+                    hasProxy[entityId] = 1;
+                    proxies.push_back({entity, OBB(), AABB()});
+                }
+            }
+        }
+
+        // Worked out again every frame, everything with a collider is assumed to move
+        void UpdateProxyBounds() {
+            for (Proxy& proxy: proxies) {
+                const TransformComponent& transform = proxy.entity.ReadComponent<TransformComponent>();
+                const BoxColliderComponent& collider = proxy.entity.ReadComponent<BoxColliderComponent>();
+                if (proxy.entity.HasComponent<SpriteComponent>()) {
+                    const SpriteComponent& sprite = proxy.entity.ReadComponent<SpriteComponent>();
+                    proxy.box = ComputeColliderOBB(transform, collider, sprite.width, sprite.height);
+                } else {
+                    proxy.box = ComputeColliderOBB(transform, collider);
+                }
+                proxy.bounds = proxy.box.GetBounds();
+            }
+        }
+
+        /**
+         * Insertion sort: last frame's order is almost right, so only a few swaps are needed
+        */
+        void SortProxies() {
+            for (size_t i = 1; i < proxies.size(); i++) {
+                Proxy proxy = proxies[i];
+                size_t j = i;
+                while (j > 0 && proxies[j - 1].bounds.minX > proxy.bounds.minX) {
+                    proxies[j] = proxies[j - 1];
+                    j--;
+                }
+                proxies[j] = proxy;
+            }
+        }
+
+    public:
+        CollisionSystem() {
+            RequireComponent<TransformComponent>();
+            RequireComponent<BoxColliderComponent>();
+        }
+
+        void SubscribeToRegistry(std::unique_ptr<Registry>& registry) {
+            registry->OnAdd<TransformComponent, CollisionSystem, &CollisionSystem::OnCollidersAdded>(this);
+            registry->OnAdd<BoxColliderComponent, CollisionSystem, &CollisionSystem::OnCollidersAdded>(this);
+            registry->OnRemove<TransformComponent, CollisionSystem, &CollisionSystem::OnCollidersRemoved>(this);
+            registry->OnRemove<BoxColliderComponent, CollisionSystem, &CollisionSystem::OnCollidersRemoved>(this);
+            Reset();
+        }
+
+        void OnCollidersAdded(const std::vector<Entity>& entities) {
+            AddProxies(entities);
+        }
+
+        // Dropped right away without breaking the order, so adding it back later can't leave two
+        void OnCollidersRemoved(const std::vector<Entity>& entities) {
+            bool removed = false;
+            for (Entity entity: entities) {
+                const int entityId = entity.GetId();
+                if (entityId < static_cast<int>(hasProxy.size()) && hasProxy[entityId]) {
+                    hasProxy[entityId] = 0;
+                    removed = true;
+                }
+            }
+            if (removed) {
+                proxies.erase(std::remove_if(proxies.begin(), proxies.end(), [this](const Proxy& proxy) {
+                    return !hasProxy[proxy.entity.GetId()];
+                }), proxies.end());
+            }
+        }
+
+        /**
+         * Starts the proxies over from the system entities, for when the entities are replaced
+         * all at once (a snapshot load).
+        */
+        void Reset() {
+            proxies.clear();
+            hasProxy.clear();
+            collisions.clear();
+            AddProxies(GetSystemEntities());
+        }
+
+        void Update(std::unique_ptr<EventBus>& eventBus) {
+            UpdateProxyBounds();
+            SortProxies();
+
+            // Broadphase: sweep along x, every box only has to look ahead until the next box starts after it ends
+            candidates.clear();
+            for (size_t i = 0; i < proxies.size(); i++) {
+                const AABB& a = proxies[i].bounds;
+
+                for (size_t j = i + 1; j < proxies.size() && proxies[j].bounds.minX <= a.maxX; j++) {
+                    const AABB& b = proxies[j].bounds;
+
+                    // x overlap is implied by the sweep
+                    if (a.minY <= b.maxY && a.maxY >= b.minY) {
+                        candidates.emplace_back(static_cast<int>(i), static_cast<int>(j));
+                    }
+                }
+            }
+
+            // Narrowphase: lay the candidate boxes out next to each other and test them in batches
+            const int candidateCount = static_cast<int>(candidates.size());
+            firstBoxes.resize(candidateCount);
+            secondBoxes.resize(candidateCount);
+            contacts.resize(candidateCount);
+            for (int i = 0; i < candidateCount; i++) {
+                firstBoxes[i] = proxies[candidates[i].first].box;
+                secondBoxes[i] = proxies[candidates[i].second].box;
+            }
+
+            TestOBBPairs(firstBoxes.data(), secondBoxes.data(), candidateCount, contacts.data());
+
+            collisions.clear();
+            for (int i = 0; i < candidateCount; i++) {
+                const OBBContact& contact = contacts[i];
+                if (contact.hit) {
+                    collisions.push_back({
+                        proxies[candidates[i].first].entity,
+                        proxies[candidates[i].second].entity,
+                        glm::vec2(contact.normalX, contact.normalY),
+                        contact.depth
+                    });
+                    const CollisionPair& collision = collisions.back();
+                    eventBus->Emit(CollisionEvent(collision.a, collision.b, collision.normal, collision.depth));
+                }
+            }
+        }
+
+        const std::vector<CollisionPair>& GetCollisions() const {
+            return collisions;
+        }
+};
+
+#endif
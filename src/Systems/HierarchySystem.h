@@ -0,0 +1,226 @@
+#ifndef HIERARCHYSYSTEM_H
+#define HIERARCHYSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/ParentComponent.h"
+#include "../Components/SpriteComponent.h"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Hierarchy System ///////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Turns the local transforms of parented entities into world transforms.
+// Children are kept in an array sorted by depth, so a parent always comes
+// before its children and one pass in order updates any hierarchy. Each
+// node knows the index of its parent's node and the world transforms live
+// in a parallel array, so a child reads its parent's result from right
+// behind it instead of going through the pools.
+// Only dirty nodes are recomputed: the ones whose ParentComponent or sprite
+// changed, whose parent (outside the hierarchy) moved, or whose parent
+// node was recomputed this pass. The results are written back to the
+// children's TransformComponent, which is what the renderer and everything
+// else read.
+// The order is only rebuilt when the shape of the hierarchy changes.
+////////////////////////////////////////////////////////////////////////////
+class HierarchySystem : public System {
+    private:
+        struct Node {
+            Entity entity = Entity(-1);
+            ParentComponent local;
+            // Index of the parent's node, -1 when the parent isn't parented itself
+            int parentSlot = -1;
+            int depth = 0;
+        };
+
+        // Sorted by depth
+        std::vector<Node> nodes;
+        // [slot => world transform of the node]
+        std::vector<TransformComponent> worldTransforms;
+        std::vector<uint8_t> dirty;
+        // [entityId => slot of its node, -1 if it has none]
+        std::vector<int> slots;
+        bool structureDirty = true;
+        // Last tick the parents outside of the hierarchy were compared against
+        uint32_t rootTick = 0;
+
+        // Used while rebuilding
+        std::vector<int> depths;
+        std::vector<int> path;
+
+        int GetSlot(int entityId) const {
+            return entityId >= 0 && entityId < static_cast<int>(slots.size()) ? slots[entityId] : -1;
+        }
+
+        /**
+         * Collects the parented entities, works out how deep each one is and sorts them so
+         * parents come first. An entity that ends up being its own ancestor is cut loose
+         * from its parent and placed at its local transform.
+        */
+        void Rebuild() {
+            nodes.clear();
+            int maxEntityId = -1;
+            for (Entity entity: GetSystemEntities()) {
+                // Taking a component off doesn't take the entity out of the system
+                if (!entity.HasComponent<ParentComponent>() || !entity.HasComponent<TransformComponent>()) {
+                    continue;
+                }
+                Node node;
+                node.entity = entity;
+                node.local = entity.ReadComponent<ParentComponent>();
+                nodes.push_back(node);
+                maxEntityId = std::max(maxEntityId, entity.GetId());
+            }
+            slots.assign(maxEntityId + 1, -1);
+            for (size_t slot = 0; slot < nodes.size(); slot++) {
+                slots[nodes[slot].entity.GetId()] = static_cast<int>(slot);
+            }
+
+            // Depth 0 is whatever isn't parented, walked up iteratively and memoized
+            const int unknown = -1;
+            const int visiting = -2;
+            depths.assign(nodes.size(), unknown);
+            for (size_t slot = 0; slot < nodes.size(); slot++) {
+                path.clear();
+                int current = static_cast<int>(slot);
+                while (current >= 0 && depths[current] == unknown) {
+                    depths[current] = visiting;
+                    path.push_back(current);
+                    current = GetSlot(nodes[current].local.parentId);
+                }
+                // The last node walked is the one whose parent closes the loop
+                if (current >= 0 && depths[current] == visiting) {
+                    Node& loop = nodes[path.back()];
+                    Logger::Err("Entity " + loop.entity.toString() + " is its own ancestor, detaching it from its parent");
+                    loop.local.parentId = -1;
+                    current = -1;
+                }
+                int depth = current >= 0 ? depths[current] : 0;
+                for (auto it = path.rbegin(); it != path.rend(); ++it) {
+                    depths[*it] = ++depth;
+                }
+            }
+
+            for (size_t slot = 0; slot < nodes.size(); slot++) {
+                nodes[slot].depth = depths[slot];
+            }
+            std::sort(nodes.begin(), nodes.end(), [](const Node& a, const Node& b) {
+                return a.depth != b.depth ? a.depth < b.depth : a.entity < b.entity;
+            });
+            for (size_t slot = 0; slot < nodes.size(); slot++) {
+                slots[nodes[slot].entity.GetId()] = static_cast<int>(slot);
+            }
+            for (Node& node: nodes) {
+                node.parentSlot = GetSlot(node.local.parentId);
+            }
+
+            worldTransforms.resize(nodes.size());
+            dirty.assign(nodes.size(), 1);
+            structureDirty = false;
+        }
+
+        // Unscaled size of the entity's sprite, zero without one
+        static vec2 GetSpriteSize(std::unique_ptr<Registry>& registry, int entityId) {
+            if (entityId < 0 || !registry->EntityHasComponent<SpriteComponent>(Entity(entityId))) {
+                return vec2(0, 0);
+            }
+            const SpriteComponent& sprite = registry->ReadComponentFromEntity<SpriteComponent>(Entity(entityId));
+            return vec2(sprite.width, sprite.height);
+        }
+
+        /**
+         * SDL draws a sprite rotated (in degrees) around the center of its scaled rect. The child
+         * is laid out on the unrotated parent, its local position scaled from the parent's
+         * top-left, and its center is then turned with the parent around the parent's center.
+         * Without sprites both centers are the positions themselves.
+        */
+        static TransformComponent Compose(const TransformComponent& parent, vec2 parentSize, const ParentComponent& local, vec2 size) {
+            const double radians = glm::radians(parent.rotation);
+            const float c = static_cast<float>(std::cos(radians));
+            const float s = static_cast<float>(std::sin(radians));
+            const vec2 scale = parent.scale * local.localScale;
+            const vec2 pivot = parent.position + parentSize * parent.scale * 0.5f;
+            const vec2 halfSize = size * scale * 0.5f;
+            const vec2 offset = parent.position + local.localPosition * parent.scale + halfSize - pivot;
+            return TransformComponent(
+                pivot + vec2(offset.x * c - offset.y * s, offset.x * s + offset.y * c) - halfSize,
+                scale,
+                parent.rotation + local.localRotation
+            );
+        }
+
+    public:
+        HierarchySystem() {
+            RequireComponent<TransformComponent>();
+            RequireComponent<ParentComponent>();
+        }
+
+        /**
+         * Run it after everything that moves parents and before anything that reads where
+         * the children are. A child's own TransformComponent is overwritten here, move it
+         * through its ParentComponent.
+        */
+        void Update(std::unique_ptr<Registry>& registry) {
+            // 1. What changed: a new parent reshapes the hierarchy, anything else only dirties the node
+            for (Entity entity: GetChangedEntities<ParentComponent, SpriteComponent>()) {
+                const int slot = GetSlot(entity.GetId());
+                if (slot < 0 || !entity.HasComponent<ParentComponent>() || !entity.HasComponent<TransformComponent>()) {
+                    structureDirty = true;
+                    continue;
+                }
+                const ParentComponent& local = entity.ReadComponent<ParentComponent>();
+                if (local.parentId != nodes[slot].local.parentId) {
+                    structureDirty = true;
+                    continue;
+                }
+                nodes[slot].local = local;
+                dirty[slot] = 1;
+            }
+            if (structureDirty) {
+                Rebuild();
+            }
+
+            // 2. Parents outside the hierarchy are only looked at through their change ticks.
+            //    Their children are depth 1, all at the front
+            const uint32_t sinceTick = rootTick;
+            rootTick = registry->AdvanceChangeTick();
+            for (size_t slot = 0; slot < nodes.size() && nodes[slot].parentSlot < 0; slot++) {
+                const Entity parent(nodes[slot].local.parentId);
+                if (parent.GetId() >= 0 && (
+                    registry->GetComponentChangeTick<TransformComponent>(parent) > sinceTick ||
+                    registry->GetComponentChangeTick<SpriteComponent>(parent) > sinceTick
+                )) {
+                    dirty[slot] = 1;
+                }
+            }
+
+            // 3. In depth order, a node is dirty if it or its parent is
+            for (size_t slot = 0; slot < nodes.size(); slot++) {
+                Node& node = nodes[slot];
+                if (node.parentSlot >= 0 && dirty[node.parentSlot]) {
+                    dirty[slot] = 1;
+                }
+                if (!dirty[slot]) {
+                    continue;
+                }
+
+                const int parentId = node.local.parentId;
+                if (node.parentSlot >= 0) {
+                    worldTransforms[slot] = Compose(worldTransforms[node.parentSlot], GetSpriteSize(registry, parentId), node.local, GetSpriteSize(registry, node.entity.GetId()));
+                } else if (parentId >= 0 && registry->EntityHasComponent<TransformComponent>(Entity(parentId))) {
+                    const TransformComponent& parent = registry->ReadComponentFromEntity<TransformComponent>(Entity(parentId));
+                    worldTransforms[slot] = Compose(parent, GetSpriteSize(registry, parentId), node.local, GetSpriteSize(registry, node.entity.GetId()));
+                } else {
+                    // No parent to follow, the local transform is the world one
+                    worldTransforms[slot] = TransformComponent(node.local.localPosition, node.local.localScale, node.local.localRotation);
+                }
+                node.entity.GetComponent<TransformComponent>() = worldTransforms[slot];
+            }
+            std::fill(dirty.begin(), dirty.end(), 0);
+        }
+};
+
+#endif
@@ -1,13 +1,12 @@
 #ifndef MOVEMENTSYSTEM_H
 #define MOVEMENTSYSTEM_H
 
-#define SCREEN_WIDTH    600
-#define SCREEN_HEIGHT   600
-
 #include "../ECS/ECS.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
 
+#include <SDL2/SDL.h>
+
 class MovementSystem : public System {
     public:
         MovementSystem(){
@@ -15,7 +14,10 @@ class MovementSystem : public System {
             RequireComponent<RigidBodyComponent>(); 
         }
 
-        void Update(double deltatime) {
+        /**
+         * Moves entities by their velocity, bouncing them off the edges of the world
+        */
+        void Update(double deltatime, const SDL_Rect& worldBounds) {
             // Loop thru all entities that the movement system is interested on
             for (Entity entity: GetSystemEntities()) {
                 // Update entity's position based on the velocity component
@@ -26,7 +28,11 @@ class MovementSystem : public System {
                 transform.position.y += rigidBody.velocity.y * deltatime;
                 transform.rotation += 20 * deltatime;
 
-                if (static_cast<int>(transform.position.x) < 0 || static_cast<int>(transform.position.x) > SCREEN_WIDTH) {
+                // Only flip a velocity that still points out, or an entity that is slow to get back in keeps flipping
+                const int x = static_cast<int>(transform.position.x);
+                const int y = static_cast<int>(transform.position.y);
+
+                if ((x < worldBounds.x && rigidBody.velocity.x < 0) || (x > worldBounds.x + worldBounds.w && rigidBody.velocity.x > 0)) {
                     // Make Velocity Negative
                     rigidBody.velocity.x *= -1;
 
@@ -36,7 +42,7 @@ class MovementSystem : public System {
                     );
                 }
 
-                if (static_cast<int>(transform.position.y) < 0 || static_cast<int>(transform.position.y) > SCREEN_HEIGHT) {
+                if ((y < worldBounds.y && rigidBody.velocity.y < 0) || (y > worldBounds.y + worldBounds.h && rigidBody.velocity.y > 0)) {
                     // Make Velocity Negative
                     rigidBody.velocity.y *= -1;
 
@@ -1,39 +1,152 @@
 #ifndef RENDERSYSTEM_H
 #define RENDERSYSTEM_H
 
-#define SCREEN_WIDTH    600
-#define SCREEN_HEIGHT   600
-
 #include "../ECS/ECS.h"
 #include "../AssetStore/AssetStore.h"
+#include "../Camera/Camera.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/SpriteComponent.h"
+#include "../Spatial/AABB.h"
+#include "../Spatial/SpatialGrid.h"
+
+#include <algorithm>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
 class RenderSystem : public System {
+    private:
+        // Reused every frame so culling doesn't allocate once it reached its peak size
+        std::vector<Entity> visibleEntities;
+        // Entities with a sprite and a transform sorted on their id, kept by the observers
+        std::vector<Entity> renderables;
+        // [entityId => whether it is in renderables]
+        std::vector<uint8_t> isRenderable;
+        // [entityId => world bounds of its sprite], only recomputed when the transform or the sprite changed
+        std::vector<AABB> spriteBounds;
+        // Registry the observers are on, and the last tick the bounds were compared against
+        Registry* observedRegistry = nullptr;
+        uint32_t boundsTick = 0;
+
+        bool IsRenderable(Entity entity) const {
+            return entity.GetId() < static_cast<int>(isRenderable.size()) && isRenderable[entity.GetId()];
+        }
+
     public:
         RenderSystem(){
             RequireComponent<SpriteComponent>();
             RequireComponent<TransformComponent>();
         }
 
-        void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore) {
-            // Loop thru all entities that the movement system is interested on
-            for (Entity entity: GetSystemEntities()) {
+        void SubscribeToRegistry(std::unique_ptr<Registry>& registry) {
+            observedRegistry = registry.get();
+            registry->OnAdd<SpriteComponent, RenderSystem, &RenderSystem::OnSpritesAdded>(this);
+            registry->OnAdd<TransformComponent, RenderSystem, &RenderSystem::OnSpritesAdded>(this);
+            registry->OnRemove<SpriteComponent, RenderSystem, &RenderSystem::OnSpritesRemoved>(this);
+            registry->OnRemove<TransformComponent, RenderSystem, &RenderSystem::OnSpritesRemoved>(this);
+            OnSpritesAdded(GetSystemEntities());
+        }
+
+        void OnSpritesAdded(const std::vector<Entity>& entities) {
+            bool added = false;
+            for (Entity entity: entities) {
+                if (IsRenderable(entity) || !entity.HasComponent<SpriteComponent>() || !entity.HasComponent<TransformComponent>()) {
+                    continue;
+                }
+                const int entityId = entity.GetId();
+                if (entityId >= static_cast<int>(isRenderable.size())) {
+                    isRenderable.resize(entityId + 1, 0);
+                }
+                if (entityId >= static_cast<int>(spriteBounds.size())) {
+                    spriteBounds.resize(entityId + 1);
+                }
+                isRenderable[entityId] = 1;
+                renderables.push_back(entity);
+                const SpriteComponent& sprite = entity.ReadComponent<SpriteComponent>();
+                spriteBounds[entityId] = ComputeSpriteBounds(entity.ReadComponent<TransformComponent>(), sprite.width, sprite.height);
+                added = true;
+            }
+            if (added) {
+                std::sort(renderables.begin(), renderables.end());
+            }
+        }
+
+        void OnSpritesRemoved(const std::vector<Entity>& entities) {
+            bool removed = false;
+            for (Entity entity: entities) {
+                if (IsRenderable(entity)) {
+                    isRenderable[entity.GetId()] = 0;
+                    removed = true;
+                }
+            }
+            if (removed) {
+                renderables.erase(std::remove_if(renderables.begin(), renderables.end(), [this](Entity entity) {
+                    return !isRenderable[entity.GetId()];
+                }), renderables.end());
+            }
+        }
+
+        /**
+         * Draws every entity whose (scaled and rotated) bounds overlap the camera view.
+         * Entities are culled before any draw work is done for them, so anything outside
+         * of the view only costs a bounds test instead of a trip through SDL_RenderCopyEx.
+         * Transforms are in world coordinates, the camera maps them to the screen.
+         *
+         * The world bounds of every sprite are kept between frames and only recomputed for
+         * the entities that changed, static scenery only costs the test. When a SpatialGrid
+         * is given, only the entities in the cells under the camera are tested, so the cost
+         * depends on what is visible rather than on the world size.
+        */
+        void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const Camera& camera, std::unique_ptr<SpatialGrid>& spatialGrid) {
+            const AABB view = AABB::FromRect(camera.GetVisibleRect());
+
+            // 0. Bring the cached bounds up to date. Through the change ticks of the renderables
+            //    rather than GetChangedEntities(): a sprite added after spawning isn't in the system
+            if (observedRegistry) {
+                const uint32_t sinceTick = boundsTick;
+                boundsTick = observedRegistry->AdvanceChangeTick();
+                for (Entity entity: renderables) {
+                    if (observedRegistry->GetComponentChangeTick<TransformComponent>(entity) > sinceTick ||
+                        observedRegistry->GetComponentChangeTick<SpriteComponent>(entity) > sinceTick) {
+                        const SpriteComponent& sprite = entity.ReadComponent<SpriteComponent>();
+                        spriteBounds[entity.GetId()] = ComputeSpriteBounds(entity.ReadComponent<TransformComponent>(), sprite.width, sprite.height);
+                    }
+                }
+            }
+
+            // 1. Cull: keep only the entities that can actually end up on screen
+            if (spatialGrid) {
+                spatialGrid->QueryRect(view, visibleEntities);
+
+                // The grid also indexes entities without sprites, and its cells reach past the view
+                visibleEntities.erase(std::remove_if(visibleEntities.begin(), visibleEntities.end(), [this, &view](Entity entity) {
+                    return !IsRenderable(entity) || !spriteBounds[entity.GetId()].Intersects(view);
+                }), visibleEntities.end());
+
+                // Grid order depends on the cells, keep the draw order stable by sorting on the id
+                std::sort(visibleEntities.begin(), visibleEntities.end());
+            } else {
+                visibleEntities.clear();
+                for (Entity entity: renderables) {
+                    if (spriteBounds[entity.GetId()].Intersects(view)) {
+                        visibleEntities.push_back(entity);
+                    }
+                }
+            }
+
+            // 2. Draw the survivors
+            for (Entity entity: visibleEntities) {
 
-                SpriteComponent& sprite = entity.GetComponent<SpriteComponent>();
-                TransformComponent& transform = entity.GetComponent<TransformComponent>();
+                const SpriteComponent& sprite = entity.ReadComponent<SpriteComponent>();
+                const TransformComponent& transform = entity.ReadComponent<TransformComponent>();
 
-                int posx = static_cast<int>(transform.position.x);
-                int posy = static_cast<int>(transform.position.y);
+                const glm::vec2 screenPosition = camera.WorldToScreen(transform.position);
 
                 SDL_Rect dstRect = { 
-                    posx, 
-                    posy, 
-                    static_cast<int>(sprite.width * transform.scale.x),
-                    static_cast<int>(sprite.height * transform.scale.y)
+                    static_cast<int>(std::floor(screenPosition.x)), 
+                    static_cast<int>(std::floor(screenPosition.y)), 
+                    static_cast<int>(sprite.width * transform.scale.x * camera.zoom),
+                    static_cast<int>(sprite.height * transform.scale.y * camera.zoom)
                 };
 
                 SDL_RenderCopyEx(
@@ -0,0 +1,49 @@
+#ifndef RENDERTEXTSYSTEM_H
+#define RENDERTEXTSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../AssetStore/AssetStore.h"
+#include "../Camera/Camera.h"
+#include "../Text/TextRenderer.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/TextLabelComponent.h"
+
+#include <cmath>
+
+class RenderTextSystem : public System {
+    public:
+        RenderTextSystem() {
+            RequireComponent<TransformComponent>();
+            RequireComponent<TextLabelComponent>();
+        }
+
+        /**
+         * Queues every label on the TextRenderer and flushes them all in one go,
+         * so the cost is one draw call per font whatever the number of labels.
+        */
+        void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, std::unique_ptr<TextRenderer>& textRenderer, const Camera& camera) {
+            for (Entity entity: GetSystemEntities()) {
+                const TextLabelComponent& label = entity.ReadComponent<TextLabelComponent>();
+                const TransformComponent& transform = entity.ReadComponent<TransformComponent>();
+
+                if (label.text.empty()) {
+                    continue;
+                }
+
+                const glm::vec2 position = label.isFixed ? transform.position : camera.WorldToScreen(transform.position);
+                textRenderer->Draw(
+                    renderer,
+                    assetStore,
+                    label.fontId,
+                    label.text,
+                    static_cast<int>(std::floor(position.x)),
+                    static_cast<int>(std::floor(position.y)),
+                    label.color
+                );
+            }
+
+            textRenderer->Flush(renderer);
+        }
+};
+
+#endif
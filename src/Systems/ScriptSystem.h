@@ -0,0 +1,60 @@
+#ifndef SCRIPTSYSTEM_H
+#define SCRIPTSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Scripting/ScriptEngine.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/ScriptComponent.h"
+
+class ScriptSystem : public System {
+    private:
+        // One batch per loaded script, kept between frames so they don't reallocate
+        std::vector<ScriptBatch> batches;
+
+    public:
+        ScriptSystem() {
+            RequireComponent<TransformComponent>();
+            RequireComponent<ScriptComponent>();
+        }
+
+        /**
+         * Groups the entities by script and calls each script once with all of its entities,
+         * then lets the behaviors that woke up run. Behaviors start the first time an entity
+         * is seen.
+        */
+        void Update(double deltaTime, std::unique_ptr<ScriptEngine>& scriptEngine) {
+            const int scriptCount = scriptEngine->GetScriptCount();
+            if (static_cast<int>(batches.size()) < scriptCount) {
+                batches.resize(scriptCount);
+            }
+            for (ScriptBatch& batch: batches) {
+                batch.entities.clear();
+            }
+
+            for (Entity entity: GetSystemEntities()) {
+                ScriptComponent& script = entity.GetComponent<ScriptComponent>();
+                if (script.scriptIndex < 0) {
+                    script.scriptIndex = scriptEngine->GetScriptId(script.scriptId);
+                    if (script.scriptIndex < 0) {
+                        continue;
+                    }
+                    if (scriptEngine->HasBehavior(script.scriptIndex)) {
+                        scriptEngine->StartBehavior(script.scriptIndex, entity);
+                    }
+                }
+                if (scriptEngine->HasUpdate(script.scriptIndex)) {
+                    batches[script.scriptIndex].entities.push_back(entity);
+                }
+            }
+
+            for (int i = 0; i < scriptCount; i++) {
+                if (!batches[i].entities.empty()) {
+                    scriptEngine->RunBatch(i, batches[i], deltaTime);
+                }
+            }
+
+            scriptEngine->ResumeTasks(deltaTime);
+        }
+};
+
+#endif
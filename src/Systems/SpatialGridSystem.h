@@ -0,0 +1,57 @@
+#ifndef SPATIALGRIDSYSTEM_H
+#define SPATIALGRIDSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../Spatial/SpatialGrid.h"
+
+/**
+ * Keeps the SpatialGrid in sync with the Transforms. Entities with a sprite are
+ * indexed by their on-screen bounds, anything else by its position only. Only the
+ * entities whose transform or sprite changed since the last update are looked at,
+ * static ones stay where they are in the grid.
+ * Run it after everything that moves entities and before anything that queries the grid.
+*/
+class SpatialGridSystem : public System {
+    private:
+        // Grid the observers take entities out of, the one given to SubscribeToRegistry
+        SpatialGrid* observedGrid = nullptr;
+
+    public:
+        SpatialGridSystem() {
+            RequireComponent<TransformComponent>();
+        }
+
+        void SubscribeToRegistry(std::unique_ptr<Registry>& registry, std::unique_ptr<SpatialGrid>& spatialGrid) {
+            observedGrid = spatialGrid.get();
+            registry->OnRemove<TransformComponent, SpatialGridSystem, &SpatialGridSystem::OnTransformsRemoved>(this);
+        }
+
+        // Without a transform there is nothing to index, don't leave them behind in the grid
+        void OnTransformsRemoved(const std::vector<Entity>& entities) {
+            for (Entity entity: entities) {
+                observedGrid->Remove(entity);
+            }
+        }
+
+        void Update(std::unique_ptr<SpatialGrid>& spatialGrid) {
+            for (Entity entity: GetChangedEntities<TransformComponent, SpriteComponent>()) {
+                // Entities stay in the system when a component is taken off, see OnTransformsRemoved
+                if (!entity.HasComponent<TransformComponent>()) {
+                    continue;
+                }
+                const TransformComponent& transform = entity.ReadComponent<TransformComponent>();
+
+                AABB bounds = { transform.position.x, transform.position.y, transform.position.x, transform.position.y };
+                if (entity.HasComponent<SpriteComponent>()) {
+                    const SpriteComponent& sprite = entity.ReadComponent<SpriteComponent>();
+                    bounds = ComputeSpriteBounds(transform, sprite.width, sprite.height);
+                }
+
+                spatialGrid->Update(entity, bounds);
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,257 @@
+#include "./TextRenderer.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+
+
+TextRenderer::TextRenderer() {
+    Logger::Success("TextRenderer constructor called!");
+}
+
+TextRenderer::~TextRenderer() {
+    Clear();
+    Logger::Success("TextRenderer destructor called!");
+}
+
+/**
+ * Destroys the atlas textures. Has to be called before the renderer goes away.
+*/
+void TextRenderer::Clear() {
+    for (auto& entry: atlases) {
+        if (entry.second.texture) {
+            SDL_DestroyTexture(entry.second.texture);
+        }
+    }
+    atlases.clear();
+}
+
+/**
+ * Atlas of a font asset, built the first time the font is used. Returns nullptr
+ * if the font isn't in the AssetStore or the atlas couldn't be built.
+*/
+TextRenderer::FontAtlas* TextRenderer::GetAtlas(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const std::string& fontId) {
+    auto existing = atlases.find(fontId);
+    if (existing != atlases.end()) {
+        return existing->second.texture ? &existing->second : nullptr;
+    }
+
+    // Remember failures too, so a missing font is reported once and not retried every frame
+    FontAtlas& atlas = atlases[fontId];
+    TTF_Font* font = assetStore->GetFont(fontId);
+    if (!font || !BuildAtlas(renderer, font, atlas)) {
+        Logger::Err("Could not build the glyph atlas of font " + fontId);
+        return nullptr;
+    }
+
+    Logger::Log("Glyph atlas for font " + fontId + " is " + std::to_string(atlas.textureWidth) + "x" + std::to_string(atlas.textureHeight));
+    return &atlas;
+}
+
+/**
+ * Renders every glyph once (in white, color comes from the vertices) and packs them in rows
+*/
+bool TextRenderer::BuildAtlas(SDL_Renderer* renderer, TTF_Font* font, FontAtlas& atlas) {
+    const SDL_Color white = {255, 255, 255, 255};
+    const int glyphCount = TEXT_LAST_GLYPH - TEXT_FIRST_GLYPH + 1;
+
+    std::vector<SDL_Surface*> surfaces(glyphCount, nullptr);
+
+    // 1. Rasterize and place the glyphs
+    int penX = 0;
+    int penY = 0;
+    int rowHeight = 0;
+    int atlasWidth = 0;
+    for (int i = 0; i < glyphCount; i++) {
+        const Uint16 character = static_cast<Uint16>(TEXT_FIRST_GLYPH + i);
+        Glyph& glyph = atlas.glyphs[i];
+        glyph = Glyph();
+
+        int minX = 0, maxX = 0, minY = 0, maxY = 0, advance = 0;
+        TTF_GlyphMetrics(font, character, &minX, &maxX, &minY, &maxY, &advance);
+        glyph.advance = advance;
+
+        surfaces[i] = TTF_RenderGlyph_Blended(font, character, white);
+        if (!surfaces[i]) {
+            continue;
+        }
+
+        if (penX + surfaces[i]->w > TEXT_ATLAS_MAX_WIDTH) {
+            penX = 0;
+            penY += rowHeight + 1;
+            rowHeight = 0;
+        }
+
+        // The rendered glyph surface covers the whole line height, so it's drawn at the pen position
+        glyph.srcRect = { penX, penY, surfaces[i]->w, surfaces[i]->h };
+        glyph.offsetX = 0;
+        glyph.offsetY = 0;
+
+        penX += surfaces[i]->w + 1;
+        rowHeight = std::max(rowHeight, surfaces[i]->h);
+        atlasWidth = std::max(atlasWidth, penX);
+    }
+    const int atlasHeight = penY + rowHeight;
+
+    // 2. Copy them all into one surface and upload it
+    bool built = false;
+    SDL_Surface* atlasSurface = atlasWidth > 0 && atlasHeight > 0 ?
+        SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, atlasHeight, 32, SDL_PIXELFORMAT_RGBA32) : nullptr;
+
+    if (atlasSurface) {
+        for (int i = 0; i < glyphCount; i++) {
+            if (surfaces[i]) {
+                // Copy the alpha as is instead of blending it onto the empty atlas
+                SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+                SDL_BlitSurface(surfaces[i], NULL, atlasSurface, &atlas.glyphs[i].srcRect);
+            }
+        }
+
+        atlas.texture = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+        if (atlas.texture) {
+            SDL_SetTextureBlendMode(atlas.texture, SDL_BLENDMODE_BLEND);
+            atlas.font = font;
+            atlas.textureWidth = atlasWidth;
+            atlas.textureHeight = atlasHeight;
+            atlas.lineHeight = TTF_FontLineSkip(font);
+            built = true;
+        }
+        SDL_FreeSurface(atlasSurface);
+    }
+
+    for (SDL_Surface* surface: surfaces) {
+        if (surface) {
+            SDL_FreeSurface(surface);
+        }
+    }
+    return built;
+}
+
+/**
+ * Lays out a string into glyph quads, or returns the layout made the last time it was drawn.
+ * Characters outside of the atlas are skipped, '\n' starts a new line.
+*/
+const TextRenderer::TextLayout& TextRenderer::GetLayout(FontAtlas& atlas, const std::string& text) {
+    auto cached = atlas.layouts.find(text);
+    if (cached != atlas.layouts.end()) {
+        cached->second.lastUsedFrame = currentFrame;
+        return cached->second;
+    }
+
+    TextLayout& layout = atlas.layouts[text];
+    layout.lastUsedFrame = currentFrame;
+    layout.quads.reserve(text.size());
+
+    int penX = 0;
+    int penY = 0;
+    Uint16 previous = 0;
+    for (char c: text) {
+        if (c == '\n') {
+            penX = 0;
+            penY += atlas.lineHeight;
+            previous = 0;
+            continue;
+        }
+
+        const int character = static_cast<unsigned char>(c);
+        if (character < TEXT_FIRST_GLYPH || character > TEXT_LAST_GLYPH) {
+            continue;
+        }
+
+        if (previous) {
+            penX += TTF_GetFontKerningSizeGlyphs(atlas.font, previous, static_cast<Uint16>(character));
+        }
+
+        const Glyph& glyph = atlas.glyphs[character - TEXT_FIRST_GLYPH];
+        if (glyph.srcRect.w > 0) {
+            layout.quads.push_back({
+                glyph.srcRect,
+                { penX + glyph.offsetX, penY + glyph.offsetY, glyph.srcRect.w, glyph.srcRect.h }
+            });
+        }
+
+        penX += glyph.advance;
+        layout.width = std::max(layout.width, penX);
+        previous = static_cast<Uint16>(character);
+    }
+    layout.height = penY + atlas.lineHeight;
+
+    return layout;
+}
+
+/**
+ * Queues a string with its top left corner at (x, y) in screen pixels.
+ * Nothing shows up until Flush().
+*/
+void TextRenderer::Draw(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const std::string& fontId,
+    const std::string& text, int x, int y, SDL_Color color) {
+    FontAtlas* atlas = GetAtlas(renderer, assetStore, fontId);
+    if (!atlas) {
+        return;
+    }
+
+    const TextLayout& layout = GetLayout(*atlas, text);
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    const float inverseWidth = 1.0f / atlas->textureWidth;
+    const float inverseHeight = 1.0f / atlas->textureHeight;
+
+    for (const GlyphQuad& quad: layout.quads) {
+        const float left = static_cast<float>(x + quad.dstRect.x);
+        const float top = static_cast<float>(y + quad.dstRect.y);
+        const float right = left + quad.dstRect.w;
+        const float bottom = top + quad.dstRect.h;
+
+        const float u0 = quad.srcRect.x * inverseWidth;
+        const float v0 = quad.srcRect.y * inverseHeight;
+        const float u1 = (quad.srcRect.x + quad.srcRect.w) * inverseWidth;
+        const float v1 = (quad.srcRect.y + quad.srcRect.h) * inverseHeight;
+
+        const int first = static_cast<int>(atlas->vertices.size());
+        atlas->vertices.push_back({ {left, top}, color, {u0, v0} });
+        atlas->vertices.push_back({ {right, top}, color, {u1, v0} });
+        atlas->vertices.push_back({ {right, bottom}, color, {u1, v1} });
+        atlas->vertices.push_back({ {left, bottom}, color, {u0, v1} });
+
+        const int quadIndices[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+        atlas->indices.insert(atlas->indices.end(), quadIndices, quadIndices + 6);
+    }
+#else
+    // No geometry API before SDL 2.0.18, draw the glyphs right away
+    SDL_SetTextureColorMod(atlas->texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(atlas->texture, color.a);
+    for (const GlyphQuad& quad: layout.quads) {
+        SDL_Rect dstRect = { x + quad.dstRect.x, y + quad.dstRect.y, quad.dstRect.w, quad.dstRect.h };
+        SDL_RenderCopy(renderer, atlas->texture, &quad.srcRect, &dstRect);
+    }
+#endif
+}
+
+void TextRenderer::FlushAtlas(SDL_Renderer* renderer, FontAtlas& atlas) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (!atlas.indices.empty()) {
+        SDL_RenderGeometry(renderer, atlas.texture, atlas.vertices.data(), static_cast<int>(atlas.vertices.size()),
+            atlas.indices.data(), static_cast<int>(atlas.indices.size()));
+    }
+#endif
+    // Keep the capacity, next frame queues about as much text
+    atlas.vertices.clear();
+    atlas.indices.clear();
+
+    // Strings that keep changing (timers, scores...) would grow the cache forever
+    if (atlas.layouts.size() > TEXT_LAYOUT_CACHE_SIZE) {
+        for (auto it = atlas.layouts.begin(); it != atlas.layouts.end();) {
+            it = it->second.lastUsedFrame != currentFrame ? atlas.layouts.erase(it) : std::next(it);
+        }
+    }
+}
+
+/**
+ * Draws everything queued since the last call, one draw call per font
+*/
+void TextRenderer::Flush(SDL_Renderer* renderer) {
+    for (auto& entry: atlases) {
+        if (entry.second.texture) {
+            FlushAtlas(renderer, entry.second);
+        }
+    }
+    currentFrame++;
+}
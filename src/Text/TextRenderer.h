@@ -0,0 +1,84 @@
+#ifndef TEXTRENDERER_H
+#define TEXTRENDERER_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "../AssetStore/AssetStore.h"
+
+// Characters baked into every atlas: printable ASCII
+const int TEXT_FIRST_GLYPH = 32;
+const int TEXT_LAST_GLYPH = 126;
+// Widest an atlas gets before glyphs wrap to a new row
+const int TEXT_ATLAS_MAX_WIDTH = 512;
+// Layouts kept per font before the ones not drawn this frame are dropped
+const size_t TEXT_LAYOUT_CACHE_SIZE = 1024;
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Text Renderer //////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Every font asset (a font file at a size) is rasterized once into a glyph
+// atlas texture. A string is laid out once into glyph quads and the layout
+// is cached by its content, so drawing the same text again is a lookup.
+// Draw() only queues the quads, Flush() sends everything that uses the same
+// atlas in a single SDL_RenderGeometry call.
+////////////////////////////////////////////////////////////////////////////
+class TextRenderer {
+    private:
+        struct Glyph {
+            SDL_Rect srcRect;
+            int offsetX;
+            int offsetY;
+            int advance;
+        };
+
+        struct GlyphQuad {
+            SDL_Rect srcRect;
+            // Relative to the top left corner of the text
+            SDL_Rect dstRect;
+        };
+
+        struct TextLayout {
+            std::vector<GlyphQuad> quads;
+            int width = 0;
+            int height = 0;
+            unsigned int lastUsedFrame = 0;
+        };
+
+        struct FontAtlas {
+            TTF_Font* font = nullptr;
+            SDL_Texture* texture = nullptr;
+            int textureWidth = 0;
+            int textureHeight = 0;
+            int lineHeight = 0;
+            Glyph glyphs[TEXT_LAST_GLYPH - TEXT_FIRST_GLYPH + 1];
+            std::unordered_map<std::string, TextLayout> layouts;
+
+            // Quads queued since the last Flush
+            std::vector<SDL_Vertex> vertices;
+            std::vector<int> indices;
+        };
+
+        std::map<std::string, FontAtlas> atlases;
+        unsigned int currentFrame = 1;
+
+        FontAtlas* GetAtlas(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const std::string& fontId);
+        bool BuildAtlas(SDL_Renderer* renderer, TTF_Font* font, FontAtlas& atlas);
+        const TextLayout& GetLayout(FontAtlas& atlas, const std::string& text);
+        void FlushAtlas(SDL_Renderer* renderer, FontAtlas& atlas);
+
+    public:
+        TextRenderer();
+        ~TextRenderer();
+
+        void Draw(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const std::string& fontId,
+            const std::string& text, int x, int y, SDL_Color color);
+        void Flush(SDL_Renderer* renderer);
+        void Clear();
+};
+
+#endif
@@ -0,0 +1,539 @@
+#include "./Tilemap.h"
+#include "../Logger/Logger.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+Tilemap::Tilemap() {
+    Logger::Success("Tilemap constructor called!");
+}
+
+Tilemap::~Tilemap() {
+    Clear();
+    Logger::Success("Tilemap destructor called!");
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Loading //////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Parses a CSV map: one row of comma separated tile indices per line,
+ * every row with the same amount of tiles.
+*/
+bool Tilemap::ParseCsv(const std::string& mapPath, std::vector<int>& tiles, int& width, int& height) {
+    std::ifstream file(mapPath);
+    if (!file.is_open()) {
+        Logger::Err("Could not open tilemap " + mapPath);
+        return false;
+    }
+
+    tiles.clear();
+    width = 0;
+    height = 0;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+
+        int rowWidth = 0;
+        std::stringstream row(line);
+        std::string cell;
+        while (std::getline(row, cell, ',')) {
+            tiles.push_back(std::atoi(cell.c_str()));
+            rowWidth++;
+        }
+
+        if (height == 0) {
+            width = rowWidth;
+        } else if (rowWidth != width) {
+            Logger::Err("Tilemap " + mapPath + " row " + std::to_string(height) + " has " +
+                std::to_string(rowWidth) + " tiles, expected " + std::to_string(width));
+            return false;
+        }
+        height++;
+    }
+
+    return true;
+}
+
+/**
+ * Reorders row-major tiles so that every chunk is contiguous, padding edge chunks
+*/
+std::vector<uint16_t> Tilemap::ToChunkMajor(const std::vector<int>& tiles, int width, int height, int chunkSize) {
+    const int chunkColumns = (width + chunkSize - 1) / chunkSize;
+    const int chunkRows = (height + chunkSize - 1) / chunkSize;
+    const size_t tilesPerChunk = static_cast<size_t>(chunkSize) * chunkSize;
+
+    std::vector<uint16_t> chunkTiles(tilesPerChunk * chunkColumns * chunkRows, TILEMAP_EMPTY_TILE);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const int tile = tiles[y * width + x];
+            const size_t chunkIndex = (y / chunkSize) * chunkColumns + x / chunkSize;
+            const size_t localIndex = (y % chunkSize) * chunkSize + x % chunkSize;
+            chunkTiles[chunkIndex * tilesPerChunk + localIndex] = (tile < 0 || tile >= TILEMAP_EMPTY_TILE) ? TILEMAP_EMPTY_TILE : static_cast<uint16_t>(tile);
+        }
+    }
+    return chunkTiles;
+}
+
+/**
+ * Loads a CSV map fully into memory
+*/
+bool Tilemap::Load(const std::string& mapPath, const std::string& tilesetId, int tileSize, int tilesetColumns) {
+    std::vector<int> parsedTiles;
+    int parsedWidth = 0;
+    int parsedHeight = 0;
+    if (!ParseCsv(mapPath, parsedTiles, parsedWidth, parsedHeight)) {
+        return false;
+    }
+
+    Clear();
+
+    this->width = parsedWidth;
+    this->height = parsedHeight;
+    this->chunkSize = TILEMAP_CHUNK_SIZE;
+    this->tilesetId = tilesetId;
+    this->tileSize = tileSize;
+    this->tilesetColumns = tilesetColumns;
+
+    chunkColumns = (width + chunkSize - 1) / chunkSize;
+    chunkRows = (height + chunkSize - 1) / chunkSize;
+    ownedTiles = ToChunkMajor(parsedTiles, width, height, chunkSize);
+    tileData = ownedTiles.data();
+
+    Logger::Log("Tilemap " + mapPath + " loaded: " + std::to_string(width) + "x" + std::to_string(height) +
+        " tiles in " + std::to_string(chunkColumns * chunkRows) + " chunks");
+    return true;
+}
+
+/**
+ * Memory maps a binary map (see TilemapFileHeader). Nothing but the header is read here,
+ * tiles are paged in by Render as the camera gets close to them.
+*/
+bool Tilemap::LoadBinary(const std::string& binaryPath, const std::string& tilesetId, int tileSize, int tilesetColumns) {
+    const int fd = open(binaryPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Logger::Err("Could not open tilemap " + binaryPath);
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < static_cast<off_t>(sizeof(TilemapFileHeader))) {
+        Logger::Err("Tilemap " + binaryPath + " is too small to be a binary tilemap");
+        close(fd);
+        return false;
+    }
+
+    const size_t fileSize = static_cast<size_t>(fileStat.st_size);
+    void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps the file alive on its own
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        Logger::Err("Could not memory map tilemap " + binaryPath);
+        return false;
+    }
+
+    TilemapFileHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+
+    // The limits keep the sums and products below far from overflowing 64 bits
+    bool validHeader = std::memcmp(header.magic, TILEMAP_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == TILEMAP_FILE_VERSION &&
+        header.width <= TILEMAP_MAX_SIDE && header.height <= TILEMAP_MAX_SIDE &&
+        header.chunkSize > 0 && header.chunkSize <= TILEMAP_MAX_CHUNK_SIZE;
+    const uint64_t chunkSide = header.chunkSize;
+    const uint64_t columns = validHeader ? (static_cast<uint64_t>(header.width) + chunkSide - 1) / chunkSide : 0;
+    const uint64_t rows = validHeader ? (static_cast<uint64_t>(header.height) + chunkSide - 1) / chunkSide : 0;
+    // Chunk indices are ints
+    validHeader = validHeader && columns * rows <= static_cast<uint64_t>(std::numeric_limits<int>::max());
+    const uint64_t expectedSize = sizeof(TilemapFileHeader) + columns * rows * chunkSide * chunkSide * sizeof(uint16_t);
+
+    if (!validHeader || expectedSize > fileSize) {
+        Logger::Err("Tilemap " + binaryPath + " is not a valid binary tilemap (version " + std::to_string(TILEMAP_FILE_VERSION) + ")");
+        munmap(mapping, fileSize);
+        return false;
+    }
+
+    Clear();
+
+    mappedFile = mapping;
+    mappedSize = fileSize;
+    tileData = reinterpret_cast<const uint16_t*>(static_cast<const char*>(mappedFile) + sizeof(TilemapFileHeader));
+
+    this->width = static_cast<int>(header.width);
+    this->height = static_cast<int>(header.height);
+    this->chunkSize = static_cast<int>(header.chunkSize);
+    this->tilesetId = tilesetId;
+    this->tileSize = tileSize;
+    this->tilesetColumns = tilesetColumns;
+    chunkColumns = static_cast<int>(columns);
+    chunkRows = static_cast<int>(rows);
+
+    // Access is by region, not front to back, so don't let the kernel read ahead the whole file
+    madvise(mappedFile, mappedSize, MADV_RANDOM);
+
+    Logger::Log("Tilemap " + binaryPath + " mapped: " + std::to_string(width) + "x" + std::to_string(height) +
+        " tiles in " + std::to_string(chunkColumns * chunkRows) + " chunks");
+    return true;
+}
+
+/**
+ * Writes a CSV map out in the binary format so it can be memory mapped by LoadBinary
+*/
+bool Tilemap::ConvertCsvToBinary(const std::string& csvPath, const std::string& binaryPath) {
+    std::vector<int> tiles;
+    int width = 0;
+    int height = 0;
+    if (!ParseCsv(csvPath, tiles, width, height)) {
+        return false;
+    }
+
+    const std::vector<uint16_t> chunkTiles = ToChunkMajor(tiles, width, height, TILEMAP_CHUNK_SIZE);
+
+    TilemapFileHeader header;
+    std::memcpy(header.magic, TILEMAP_FILE_MAGIC, sizeof(header.magic));
+    header.version = TILEMAP_FILE_VERSION;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.chunkSize = static_cast<uint32_t>(TILEMAP_CHUNK_SIZE);
+    header.reserved = 0;
+
+    std::ofstream file(binaryPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        Logger::Err("Could not create binary tilemap " + binaryPath);
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(chunkTiles.data()), chunkTiles.size() * sizeof(uint16_t));
+
+    if (!file.good()) {
+        Logger::Err("Could not write binary tilemap " + binaryPath);
+        return false;
+    }
+
+    Logger::Success("Tilemap " + csvPath + " converted to " + binaryPath);
+    return true;
+}
+
+void Tilemap::Unmap() {
+    if (mappedFile) {
+        munmap(mappedFile, mappedSize);
+        mappedFile = nullptr;
+        mappedSize = 0;
+    }
+}
+
+/**
+ * Destroys the chunk textures and drops the map. Has to be called before the renderer goes away.
+*/
+void Tilemap::Clear() {
+    for (auto& entry: residentChunks) {
+        if (entry.second.texture) {
+            SDL_DestroyTexture(entry.second.texture);
+        }
+    }
+    residentChunks.clear();
+    residentRange = ChunkRange();
+
+    editedChunks.clear();
+    ownedTiles.clear();
+    Unmap();
+    tileData = nullptr;
+
+    width = 0;
+    height = 0;
+    chunkColumns = 0;
+    chunkRows = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Tiles ////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+const uint16_t* Tilemap::GetChunkTiles(int chunkIndex) const {
+    if (!editedChunks.empty()) {
+        auto edited = editedChunks.find(chunkIndex);
+        if (edited != editedChunks.end()) {
+            return edited->second.data();
+        }
+    }
+    return tileData + static_cast<size_t>(chunkIndex) * chunkSize * chunkSize;
+}
+
+int Tilemap::GetTile(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return -1;
+    }
+    const int chunkIndex = (y / chunkSize) * chunkColumns + x / chunkSize;
+    const uint16_t tile = GetChunkTiles(chunkIndex)[(y % chunkSize) * chunkSize + x % chunkSize];
+    return tile == TILEMAP_EMPTY_TILE ? -1 : tile;
+}
+
+/**
+ * Changes a tile, only the chunk that contains it gets re-rendered.
+ * Mapped maps are read only, so the chunk is copied the first time it's edited.
+*/
+void Tilemap::SetTile(int x, int y, int tile) {
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return;
+    }
+
+    const uint16_t value = (tile < 0 || tile >= TILEMAP_EMPTY_TILE) ? TILEMAP_EMPTY_TILE : static_cast<uint16_t>(tile);
+    const int chunkIndex = (y / chunkSize) * chunkColumns + x / chunkSize;
+    const size_t tilesPerChunk = static_cast<size_t>(chunkSize) * chunkSize;
+    const size_t localIndex = (y % chunkSize) * chunkSize + x % chunkSize;
+
+    if (GetChunkTiles(chunkIndex)[localIndex] == value) {
+        return;
+    }
+
+    if (mappedFile) {
+        auto edited = editedChunks.find(chunkIndex);
+        if (edited == editedChunks.end()) {
+            const uint16_t* original = tileData + chunkIndex * tilesPerChunk;
+            edited = editedChunks.emplace(chunkIndex, std::vector<uint16_t>(original, original + tilesPerChunk)).first;
+        }
+        edited->second[localIndex] = value;
+    } else {
+        ownedTiles[chunkIndex * tilesPerChunk + localIndex] = value;
+    }
+
+    auto resident = residentChunks.find(chunkIndex);
+    if (resident != residentChunks.end()) {
+        resident->second.dirty = true;
+    }
+}
+
+int Tilemap::GetWidth() const {
+    return width;
+}
+
+int Tilemap::GetHeight() const {
+    return height;
+}
+
+int Tilemap::GetTileSize() const {
+    return tileSize;
+}
+
+/**
+ * World rect covered by the map
+*/
+SDL_Rect Tilemap::GetWorldBounds() const {
+    return { 0, 0, width * tileSize, height * tileSize };
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Streaming ////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * World rect covered by a chunk. Chunks on the right/bottom edges can be smaller.
+*/
+SDL_Rect Tilemap::GetChunkRect(int chunkX, int chunkY) const {
+    const int firstTileX = chunkX * chunkSize;
+    const int firstTileY = chunkY * chunkSize;
+    const int tilesX = std::min(chunkSize, width - firstTileX);
+    const int tilesY = std::min(chunkSize, height - firstTileY);
+    return { firstTileX * tileSize, firstTileY * tileSize, tilesX * tileSize, tilesY * tileSize };
+}
+
+/**
+ * Chunks that overlap the area, grown by `margin` chunks on every side and clamped to the map
+*/
+Tilemap::ChunkRange Tilemap::GetChunkRange(const SDL_Rect& area, int margin) const {
+    const int chunkPixels = chunkSize * tileSize;
+    // Floor division, the camera can be left/above the map
+    auto chunkCoord = [chunkPixels](int value) {
+        return value >= 0 ? value / chunkPixels : -((-value + chunkPixels - 1) / chunkPixels);
+    };
+
+    ChunkRange range;
+    range.firstX = std::max(0, chunkCoord(area.x) - margin);
+    range.firstY = std::max(0, chunkCoord(area.y) - margin);
+    range.lastX = std::min(chunkColumns - 1, chunkCoord(area.x + area.w) + margin);
+    range.lastY = std::min(chunkRows - 1, chunkCoord(area.y + area.h) + margin);
+    return range;
+}
+
+/**
+ * Tells the kernel about a run of chunks in one chunk row of a mapped map: either that we
+ * are about to read them, or that we are done with them. When releasing, pages shared
+ * with chunks outside of the run are left alone.
+*/
+void Tilemap::AdviseChunks(int firstChunkX, int lastChunkX, int chunkY, bool willNeed) const {
+    if (!mappedFile || firstChunkX > lastChunkX) {
+        return;
+    }
+
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t chunkBytes = static_cast<size_t>(chunkSize) * chunkSize * sizeof(uint16_t);
+    const size_t firstChunk = static_cast<size_t>(chunkY) * chunkColumns + firstChunkX;
+
+    size_t start = sizeof(TilemapFileHeader) + firstChunk * chunkBytes;
+    size_t end = start + (lastChunkX - firstChunkX + 1) * chunkBytes;
+
+    if (willNeed) {
+        start = start / pageSize * pageSize;
+        end = std::min(mappedSize, (end + pageSize - 1) / pageSize * pageSize);
+    } else {
+        start = (start + pageSize - 1) / pageSize * pageSize;
+        end = end / pageSize * pageSize;
+    }
+
+    if (start < end) {
+        madvise(static_cast<char*>(mappedFile) + start, end - start, willNeed ? MADV_WILLNEED : MADV_DONTNEED);
+    }
+}
+
+/**
+ * Moves the resident window: chunks leaving it give back their texture (and their pages
+ * for mapped maps), chunks entering it get their pages requested before they are drawn.
+*/
+void Tilemap::UpdateResidency(const ChunkRange& range) {
+    const ChunkRange& old = residentRange;
+    if (old.firstX == range.firstX && old.firstY == range.firstY && old.lastX == range.lastX && old.lastY == range.lastY) {
+        return;
+    }
+
+    for (auto it = residentChunks.begin(); it != residentChunks.end();) {
+        const int chunkX = it->first % chunkColumns;
+        const int chunkY = it->first / chunkColumns;
+        const bool inside = chunkX >= range.firstX && chunkX <= range.lastX && chunkY >= range.firstY && chunkY <= range.lastY;
+        if (inside) {
+            ++it;
+            continue;
+        }
+        if (it->second.texture) {
+            SDL_DestroyTexture(it->second.texture);
+        }
+        it = residentChunks.erase(it);
+    }
+
+    if (mappedFile) {
+        // Release the parts of the old window that the new one doesn't cover...
+        for (int chunkY = old.firstY; chunkY <= old.lastY; chunkY++) {
+            if (chunkY < range.firstY || chunkY > range.lastY) {
+                AdviseChunks(old.firstX, old.lastX, chunkY, false);
+                continue;
+            }
+            AdviseChunks(old.firstX, std::min(old.lastX, range.firstX - 1), chunkY, false);
+            AdviseChunks(std::max(old.firstX, range.lastX + 1), old.lastX, chunkY, false);
+        }
+        // ...and ask for the new one ahead of drawing it
+        for (int chunkY = range.firstY; chunkY <= range.lastY; chunkY++) {
+            AdviseChunks(range.firstX, range.lastX, chunkY, true);
+        }
+    }
+
+    residentRange = range;
+}
+
+/**
+ * Flags every chunk for re-rendering, needed when the renderer lost the
+ * contents of its render targets (SDL_RENDER_TARGETS_RESET)
+*/
+void Tilemap::Invalidate() {
+    for (auto& entry: residentChunks) {
+        entry.second.dirty = true;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// Rendering ////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////
+
+void Tilemap::RenderTile(SDL_Renderer* renderer, SDL_Texture* tileset, int tile, const SDL_Rect& dstRect) const {
+    if (tile == TILEMAP_EMPTY_TILE) {
+        return;
+    }
+    SDL_Rect srcRect = { (tile % tilesetColumns) * tileSize, (tile / tilesetColumns) * tileSize, tileSize, tileSize };
+    SDL_RenderCopy(renderer, tileset, &srcRect, &dstRect);
+}
+
+/**
+ * Renders all the tiles of a chunk into the chunk texture, creating it if needed.
+ * Returns false if the renderer can't give us a render target.
+*/
+bool Tilemap::RedrawChunk(SDL_Renderer* renderer, SDL_Texture* tileset, Chunk& chunk, int chunkX, int chunkY) {
+    const SDL_Rect chunkRect = GetChunkRect(chunkX, chunkY);
+
+    if (!chunk.texture) {
+        chunk.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, chunkRect.w, chunkRect.h);
+        if (!chunk.texture) {
+            return false;
+        }
+        SDL_SetTextureBlendMode(chunk.texture, SDL_BLENDMODE_BLEND);
+    }
+
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    if (SDL_SetRenderTarget(renderer, chunk.texture) != 0) {
+        return false;
+    }
+
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+
+    const uint16_t* chunkTiles = GetChunkTiles(chunkY * chunkColumns + chunkX);
+    for (int y = 0; y < chunkRect.h / tileSize; y++) {
+        for (int x = 0; x < chunkRect.w / tileSize; x++) {
+            const SDL_Rect dstRect = { x * tileSize, y * tileSize, tileSize, tileSize };
+            RenderTile(renderer, tileset, chunkTiles[y * chunkSize + x], dstRect);
+        }
+    }
+
+    SDL_SetRenderTarget(renderer, previousTarget);
+    chunk.dirty = false;
+    return true;
+}
+
+/**
+ * Draws the chunks that overlap the camera, re-rendering the dirty ones first.
+ * If a chunk can't be cached (no render target support) its tiles are drawn directly.
+*/
+void Tilemap::Render(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const Camera& camera) {
+    if (!tileData) {
+        return;
+    }
+
+    const SDL_Rect view = camera.GetVisibleRect();
+    UpdateResidency(GetChunkRange(view, TILEMAP_CHUNK_MARGIN));
+
+    SDL_Texture* tileset = assetStore->GetTexture(tilesetId);
+    const ChunkRange visible = GetChunkRange(view, 0);
+
+    for (int chunkY = visible.firstY; chunkY <= visible.lastY; chunkY++) {
+        for (int chunkX = visible.firstX; chunkX <= visible.lastX; chunkX++) {
+            Chunk& chunk = residentChunks[chunkY * chunkColumns + chunkX];
+            const SDL_Rect chunkRect = GetChunkRect(chunkX, chunkY);
+
+            bool cached = !chunk.dirty || RedrawChunk(renderer, tileset, chunk, chunkX, chunkY);
+            if (cached) {
+                const SDL_Rect dstRect = camera.WorldToScreen(chunkRect);
+                SDL_RenderCopy(renderer, chunk.texture, NULL, &dstRect);
+                continue;
+            }
+
+            // Fallback, one copy per tile
+            const uint16_t* chunkTiles = GetChunkTiles(chunkY * chunkColumns + chunkX);
+            for (int y = 0; y < chunkRect.h / tileSize; y++) {
+                for (int x = 0; x < chunkRect.w / tileSize; x++) {
+                    const SDL_Rect tileRect = { chunkRect.x + x * tileSize, chunkRect.y + y * tileSize, tileSize, tileSize };
+                    RenderTile(renderer, tileset, chunkTiles[y * chunkSize + x], camera.WorldToScreen(tileRect));
+                }
+            }
+        }
+    }
+}
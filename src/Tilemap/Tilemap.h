@@ -0,0 +1,130 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include <SDL2/SDL.h>
+#include "../AssetStore/AssetStore.h"
+#include "../Camera/Camera.h"
+
+// Tiles per chunk side for maps loaded from CSV. A chunk is drawn with a single SDL_RenderCopy
+const int TILEMAP_CHUNK_SIZE = 16;
+// Chunks around the camera that stay resident so scrolling doesn't hitch on every chunk border
+const int TILEMAP_CHUNK_MARGIN = 1;
+// Tile index that means "nothing here"
+const uint16_t TILEMAP_EMPTY_TILE = 0xFFFF;
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////// Binary tilemap format //////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// [TilemapFileHeader][tiles...]
+// Tiles are uint16 indices into the tileset stored chunk by chunk (chunks in
+// row-major order, tiles row-major inside each chunk), so everything needed
+// to draw one chunk is a single contiguous block of the file. Edge chunks are
+// padded with TILEMAP_EMPTY_TILE.
+////////////////////////////////////////////////////////////////////////////
+struct TilemapFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t chunkSize;
+    uint32_t reserved;
+};
+
+const char TILEMAP_FILE_MAGIC[4] = {'T', 'M', 'A', 'P'};
+const uint32_t TILEMAP_FILE_VERSION = 1;
+// Largest map side and chunk side a binary map may declare, in tiles. Keeps every size
+// worked out from the header well inside an int
+const uint32_t TILEMAP_MAX_SIDE = 1 << 20;
+const uint32_t TILEMAP_MAX_CHUNK_SIZE = 256;
+
+////////////////////////////////////////////////////////////////////////////
+/////////////////////////////// Tilemap ////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+// Background made out of tiles from a tileset texture, split in square
+// chunks. Each chunk near the camera is pre-rendered into its own render
+// target texture and only re-rendered when one of its tiles changes, so a
+// full screen of tiles costs one copy per visible chunk instead of one per
+// tile. Chunks that drift away from the camera give their texture back.
+//
+// CSV maps are parsed into memory. Binary maps are memory mapped instead:
+// opening them is instant whatever their size, the pages around the camera
+// are requested ahead of time and the ones left behind are released, so
+// only the region being looked at occupies RAM. Edits to a mapped map are
+// copy-on-write per chunk and never touch the file.
+////////////////////////////////////////////////////////////////////////////
+class Tilemap {
+    private:
+        struct Chunk {
+            SDL_Texture* texture = nullptr;
+            bool dirty = true;
+        };
+
+        struct ChunkRange {
+            int firstX = 0;
+            int firstY = 0;
+            int lastX = -1;
+            int lastY = -1;
+        };
+
+        // Size of the map in tiles
+        int width = 0;
+        int height = 0;
+        int chunkSize = TILEMAP_CHUNK_SIZE;
+        int chunkColumns = 0;
+        int chunkRows = 0;
+
+        // Chunk-major tiles (same layout as the binary file), either ownedTiles or the mapping
+        const uint16_t* tileData = nullptr;
+        std::vector<uint16_t> ownedTiles;
+        void* mappedFile = nullptr;
+        size_t mappedSize = 0;
+        // [chunkIndex => private copy of the tiles] for edited chunks of a mapped map
+        std::unordered_map<int, std::vector<uint16_t>> editedChunks;
+
+        std::string tilesetId;
+        int tileSize = 0;
+        int tilesetColumns = 0;
+
+        // [chunkIndex => Chunk] only for the chunks around the camera
+        std::unordered_map<int, Chunk> residentChunks;
+        ChunkRange residentRange;
+
+        static std::vector<uint16_t> ToChunkMajor(const std::vector<int>& tiles, int width, int height, int chunkSize);
+
+        void Unmap();
+        const uint16_t* GetChunkTiles(int chunkIndex) const;
+        SDL_Rect GetChunkRect(int chunkX, int chunkY) const;
+        ChunkRange GetChunkRange(const SDL_Rect& area, int margin) const;
+        void AdviseChunks(int firstChunkX, int lastChunkX, int chunkY, bool willNeed) const;
+        void UpdateResidency(const ChunkRange& range);
+        void RenderTile(SDL_Renderer* renderer, SDL_Texture* tileset, int tile, const SDL_Rect& dstRect) const;
+        bool RedrawChunk(SDL_Renderer* renderer, SDL_Texture* tileset, Chunk& chunk, int chunkX, int chunkY);
+
+    public:
+        Tilemap();
+        ~Tilemap();
+
+        bool Load(const std::string& mapPath, const std::string& tilesetId, int tileSize, int tilesetColumns);
+        bool LoadBinary(const std::string& binaryPath, const std::string& tilesetId, int tileSize, int tilesetColumns);
+        static bool ConvertCsvToBinary(const std::string& csvPath, const std::string& binaryPath);
+        static bool ParseCsv(const std::string& mapPath, std::vector<int>& tiles, int& width, int& height);
+        void Clear();
+
+        int GetTile(int x, int y) const;
+        void SetTile(int x, int y, int tile);
+
+        int GetWidth() const;
+        int GetHeight() const;
+        int GetTileSize() const;
+        SDL_Rect GetWorldBounds() const;
+
+        void Invalidate();
+        void Render(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const Camera& camera);
+};
+
+#endif